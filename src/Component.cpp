@@ -8,9 +8,14 @@
 
 #include "Component.h"
 
+#include "_bits/ComponentSet.h"
+
 
 /**
  * @brief Update surrounding in NSEWUD direction
+ *
+ * Only the neighbours that are sensitive to us are updated.
+ *
  * @param engine	The engine being used
  * @param coords	The coordinates' center
  */
@@ -18,27 +23,36 @@ void Redstone::Component::updateSurrounding(
 	Redstone::Engine & engine,
 	const Redstone::Map::Coordinates & coords)
 {
-	Map::Coordinates test_coords = coords;
-
-	--test_coords.x;
-	this->markUpdate(engine, test_coords);
-
-	test_coords.x += 2;
-	this->markUpdate(engine, test_coords);
-
-	--test_coords.x;
-	--test_coords.z;
-	this->markUpdate(engine, test_coords);
-
-	test_coords.z += 2;
-	this->markUpdate(engine, test_coords);
-
-	--test_coords.z;
-	--test_coords.y;
-	this->markUpdate(engine, test_coords);
-
-	test_coords.y += 2;
-	this->markUpdate(engine, test_coords);
+	Map::Cursor cursor(engine.getMap(), coords);
+
+	// We need this for all six directions
+	auto process = [&](int x, int y, int z, Map::Direction direction) {
+		Map::Coordinates test_coords = coords;
+		test_coords.x += x;
+		test_coords.y += y;
+		test_coords.z += z;
+
+		const Component * neighbor = cursor.at(x, y, z);
+		if (neighbor == nullptr)
+			return;
+
+#ifdef REDSTONE_VIRTUAL_DISPATCH
+		bool sensitive = neighbor->isSensitiveTo(*this, direction);
+#else
+		bool sensitive = KnownComponents::visit(*neighbor, [&](const auto & n) {
+			return n.isSensitiveTo(*this, direction);
+		});
+#endif
+		if (sensitive)
+			this->markUpdate(engine, test_coords);
+	};
+
+	// Each of them is asked with the direction from us towards it, which
+	// is the direction from its neighbour that isSensitiveTo expects
+	process(-1, 0, 0, Map::Direction::WEST);
+	process(1, 0, 0, Map::Direction::EAST);
+	process(0, 0, -1, Map::Direction::NORTH);
+	process(0, 0, 1, Map::Direction::SOUTH);
+	process(0, -1, 0, Map::Direction::DOWN);
+	process(0, 1, 0, Map::Direction::UP);
 }
-
-
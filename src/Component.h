@@ -7,13 +7,16 @@
  *
  * Also included is an enumeration of all components.  This will function as 
  * their IDs, which can be used elsewhere in if-statements.  This way of 
- * doing it will make for cleaner code than using dynamic_cast tests.
+ * doing it will make for cleaner code than using dynamic_cast tests.  Once
+ * the ID is known, componentCast gets the right class without any RTTI.
  *
  */
 
 #ifndef REDSTONE_COMPONENT_H
 #define REDSTONE_COMPONENT_H
 
+#include <cassert>
+
 #include "Engine.h"
 #include "Map.h"
 
@@ -62,6 +65,29 @@ namespace Redstone
 		 */
 		virtual Component * clone() const = 0;
 
+		/**
+		 * @brief Clone the component into some memory
+		 *
+		 * Maps use this to keep their components in one big arena.
+		 * Components that don't support it are cloned onto the heap.
+		 *
+		 * @param memory	getSize() bytes to build the clone in
+		 * @returns The clone, or nullptr if it isn't supported
+		 */
+		virtual Component * cloneAt(void * /*memory*/) const
+		{
+			return nullptr;
+		}
+
+		/**
+		 * @brief Get the number of bytes cloneAt needs
+		 * @returns The size of the class, or 0 if cloneAt isn't supported
+		 */
+		virtual size_t getSize() const
+		{
+			return 0;
+		}
+
 		/**
 		 * @brief Update the component
 		 * @param engine	The engine being used
@@ -82,6 +108,99 @@ namespace Redstone
 		 */
 		virtual bool operator==(const Component & b) const = 0;
 
+		/**
+		 * @brief Get whether the component gives off power or changes by itself
+		 *
+		 * When a map is first run, only active components and their
+		 * neighbours are updated.  Anything else can't change until one of
+		 * those asks it to.
+		 *
+		 * @returns true if it is active
+		 */
+		virtual bool isActive() const
+		{
+			return false;
+		}
+
+		/**
+		 * @brief Get whether this is a shared instance
+		 *
+		 * Components without any state can use one instance for every
+		 * voxel.  Maps hold on to shared instances without owning them, so
+		 * they are never deleted.
+		 *
+		 * @returns true if it is shared
+		 */
+		virtual bool isShared() const
+		{
+			return false;
+		}
+
+		/**
+		 * @brief Get whether a change in a neighbour can change us
+		 *
+		 * When a component changes, only the neighbours that are sensitive
+		 * to it are updated.  The direction is the way from the neighbour
+		 * to us, so a neighbour below us comes from Map::Direction::UP.
+		 *
+		 * @param neighbor	The component next to us
+		 * @param direction	The direction from the neighbour towards us
+		 * @returns true if it may change our state
+		 */
+		virtual bool isSensitiveTo(
+			const Component & /*neighbor*/,
+			const Map::Direction & /*direction*/) const
+		{
+			return false;
+		}
+
+		/**
+		 * @brief Get a number that sums up the state of the component
+		 *
+		 * Two components of the same type with the same key will act the
+		 * same from here on.  The engine hashes these to spot repeating
+		 * circuits.
+		 *
+		 * @returns The state key, 0 for components without state
+		 */
+		virtual unsigned getStateKey() const
+		{
+			return 0;
+		}
+
+		/**
+		 * @brief Set the state from a key made by getStateKey
+		 * @note For initialization only, please.
+		 * @param key	The state key
+		 */
+		virtual void setStateKey(unsigned /*key*/)
+		{}
+
+		/**
+		 * @brief Get a number that sums up what can be seen of the component
+		 *
+		 * This is the part of the state that matters to anyone looking at
+		 * the map, like a dust's level or whether a torch is lit.  The
+		 * engine uses it to list what changed.
+		 *
+		 * @returns The visible state, 0 for components without any
+		 */
+		virtual unsigned getVisibleState() const
+		{
+			return 0;
+		}
+
+		/**
+		 * @brief Move any remembered tick numbers forward
+		 *
+		 * The engine calls this when it skips over whole cycles of a
+		 * repeating circuit without running them.
+		 *
+		 * @param ticks	The number of ticks skipped
+		 */
+		virtual void shiftTicks(int /*ticks*/)
+		{}
+
 
 	protected:
 
@@ -105,6 +224,60 @@ namespace Redstone
 			engine.markNextUpdate(coords);
 		}
 
+		/**
+		 * @brief Set a map location to be updated some ticks from now
+		 * @param engine	The engine being used
+		 * @param coords	The coordinates to mark to update
+		 * @param delay	The number of ticks to wait, 1 being the next tick
+		 */
+		void scheduleUpdate(Engine & engine, const Map::Coordinates & coords, unsigned delay)
+		{
+			engine.scheduleUpdate(coords, delay);
+		}
+
+		/**
+		 * @brief Check whether a map location is waiting for a later tick
+		 * @param engine	The engine being used
+		 * @param coords	The coordinates to check
+		 * @returns true if it has been scheduled and hasn't come due yet
+		 */
+		bool isUpdateScheduled(Engine & engine, const Map::Coordinates & coords)
+		{
+			return engine.isUpdateScheduled(coords);
+		}
+
+		/**
+		 * @brief Get ready to change a component other than this one
+		 * @param engine	The engine being used
+		 * @param coords	The location of the other component
+		 * @returns What to pass to endChange
+		 */
+		unsigned beginChange(Engine & engine, const Map::Coordinates & coords)
+		{
+			return engine.beginChange(coords);
+		}
+
+		/**
+		 * @brief Finish a change started with beginChange
+		 * @param engine	The engine being used
+		 * @param coords	The location of the other component
+		 * @param visible	What beginChange returned
+		 */
+		void endChange(Engine & engine, const Map::Coordinates & coords, unsigned visible)
+		{
+			engine.endChange(coords, visible);
+		}
+
+		/**
+		 * @brief Get the engine's cache of dust wires
+		 * @param engine	The engine being used
+		 * @returns The cache
+		 */
+		DustGraph & dustGraph(Engine & engine)
+		{
+			return engine._dustGraph;
+		}
+
 		/**
 		 * @brief Update surrounding in NSEWUD direction
 		 * @param engine	The engine being used
@@ -173,6 +346,50 @@ namespace Redstone
 	};
 
 
+	/**
+	 * @brief Cast a component to its class, once its ID has been checked
+	 *
+	 * This is a plain static_cast, so it costs nothing.  Debug builds
+	 * assert that the ID is right; release builds take it on trust.
+	 *
+	 * @param comp	The component, whose getId() is T::TYPE, or nullptr
+	 * @tparam T	The class of the component
+	 * @returns The component as a T
+	 */
+	template<typename T>
+	T * componentCast(Component * comp)
+	{
+		assert(comp == nullptr || comp->getId() == T::TYPE);
+		return static_cast<T *>(comp);
+	}
+
+	/**
+	 * @brief Cast a component to its class, once its ID has been checked
+	 * @param comp	The component, whose getId() is T::TYPE, or nullptr
+	 * @tparam T	The class of the component
+	 * @returns The component as a T
+	 */
+	template<typename T>
+	const T * componentCast(const Component * comp)
+	{
+		assert(comp == nullptr || comp->getId() == T::TYPE);
+		return static_cast<const T *>(comp);
+	}
+
+	/**
+	 * @brief Cast a component to its class, once its ID has been checked
+	 * @param comp	The component, whose getId() is T::TYPE
+	 * @tparam T	The class of the component
+	 * @returns The component as a T
+	 */
+	template<typename T>
+	const T & componentCast(const Component & comp)
+	{
+		assert(comp.getId() == T::TYPE);
+		return static_cast<const T &>(comp);
+	}
+
+
 } // End of namespace
 
 
@@ -9,7 +9,15 @@
 #include "Engine.h"
 
 #include "Component.h"
+#include "PackedMap.h"
+#include "_bits/ComponentSet.h"
 #include <algorithm>
+#include <chrono>
+#include <utility>
+
+
+static_assert(static_cast<int>(Redstone::Component::ID::END_OF_ENUM) <= Redstone::Engine::ID_SLOTS,
+	"Engine::ID_SLOTS is too small for all of the component IDs");
 
 
 /**
@@ -17,23 +25,170 @@
  */
 void Redstone::Engine::run()
 {
-	while (! this->_nextUpdates.empty()) {
-		this->_updates.push(this->_nextUpdates.front());
-		this->_nextUpdates.pop();
-	}
+	this->_runTick();
+}
 
-	// Go through updates
-	while (!this->_updates.empty()) {
-		Redstone::Map::Coordinates coords = this->_updates.front();
-		Redstone::Component * comp = this->_map.get(coords);
 
-		this->_updates.pop();
-		if (comp)
-			comp->update(*this, coords);
+/**
+ * @brief Run part of a tick, up to a number of updates
+ * @param maxUpdates	The most updates to take off the queue
+ * @returns true if the tick was finished
+ */
+bool Redstone::Engine::runUpdates(unsigned long long maxUpdates)
+{
+	return this->_runPartialTick(maxUpdates, std::chrono::steady_clock::time_point::max());
+}
+
+
+/**
+ * @brief Run part of a tick, for about some amount of time
+ * @param budget	How long to run for
+ * @returns true if the tick was finished
+ */
+bool Redstone::Engine::runFor(std::chrono::microseconds budget)
+{
+	return this->_runPartialTick(~0ull, std::chrono::steady_clock::now() + budget);
+}
+
+
+/**
+ * @brief Run the map for a number of ticks
+ * @param ticks	The number of ticks to run
+ * @returns What happened in those ticks
+ */
+Redstone::Engine::RunStats Redstone::Engine::runTicks(int ticks)
+{
+	return this->_runTicks(ticks, false);
+}
+
+
+/**
+ * @brief Run the map until it is still, or for a number of ticks
+ * @param limit	The most ticks to run
+ * @returns What happened in those ticks
+ */
+Redstone::Engine::RunStats Redstone::Engine::runUntilStill(int limit)
+{
+	return this->_runTicks(limit, true);
+}
+
+
+/**
+ * @brief Run the map for a number of ticks, skipping repeated cycles
+ * @param ticks	The number of ticks to run
+ * @returns What happened in those ticks
+ */
+Redstone::Engine::RunStats Redstone::Engine::fastForward(int ticks)
+{
+	RunStats stats;
+	bool detecting = this->_detectCycles;
+	this->setCycleDetection(true);
+
+	// Run it until we know the period
+	while (stats.ticks < ticks && this->_period == 0)
+		stats += this->_runTicks(1, false);
+
+	if (stats.ticks != ticks) {
+
+		// Jump over whole cycles, which leaves everything as it is now
+		int cycles = (ticks - stats.ticks) / this->_period;
+		int skipped = cycles * this->_period;
+		if (skipped) {
+			this->_map.forEach([skipped](const Map::Coordinates &, Component * comp) {
+				comp->shiftTicks(skipped);
+			});
+			this->_tickNumber += skipped;
+			stats.ticks += skipped;
+		}
+
+		// And run what's left over
+		stats += this->_runTicks(ticks - stats.ticks, false);
 	}
 
-	// Increment tick number, and done!
-	++ this->_tickNumber;
+	// Leave it the way it was, so idle ticks are skipped again if it was
+	// off.  The period is kept for getPeriod, and found again from scratch
+	// once it is turned back on.
+	this->_detectCycles = detecting;
+	return stats;
+}
+
+
+/**
+ * @brief Turn watching for repeated states on or off
+ * @param on	true to turn it on
+ */
+void Redstone::Engine::setCycleDetection(bool on)
+{
+	if (on == this->_detectCycles)
+		return;
+
+	this->_detectCycles = on;
+	this->_restartCycle();
+}
+
+
+/**
+ * @brief Turn keeping a list of changed locations on or off
+ * @param on	true to turn it on
+ */
+void Redstone::Engine::setChangeTracking(bool on)
+{
+	this->_trackChanges = on;
+	if (!on)
+		this->clearChanges();
+}
+
+
+/**
+ * @brief Get the locations that changed since clearChanges
+ * @returns The map indices of the locations, in the order they first
+ *	changed
+ */
+const std::vector<uint32_t> & Redstone::Engine::getChanges()
+{
+	this->_checkLayout();
+	return this->_changes;
+}
+
+
+/**
+ * @brief Empty the list of changed locations
+ */
+void Redstone::Engine::clearChanges()
+{
+	this->_checkLayout();
+	for (auto index : this->_changes)
+		this->_pending[index] &= ~PENDING_CHANGED;
+	this->_changes.clear();
+}
+
+
+/**
+ * @brief Set all the statistics back to zero
+ */
+void Redstone::Engine::resetStats()
+{
+	this->_tickStats = Stats();
+	this->_lastTickStats = Stats();
+	this->_totalStats = Stats();
+}
+
+
+/**
+ * @brief Measure the heap memory the engine holds
+ * @returns The bytes, broken down by what they hold
+ */
+Redstone::Engine::MemoryUsage Redstone::Engine::memoryUsage() const
+{
+	MemoryUsage usage;
+	usage.map = this->_map.memoryUsage();
+	usage.updateQueue = this->_updates.capacity() * sizeof(uint32_t);
+	usage.scheduled = this->_scheduled.memoryUsage()
+		+ this->_laterDue.capacity() * sizeof(unsigned long long);
+	usage.pending = this->_pending.capacity() * sizeof(unsigned char);
+	usage.changes = this->_changes.capacity() * sizeof(uint32_t);
+	usage.dustGraph = this->_dustGraph.memoryUsage();
+	return usage;
 }
 
 
@@ -44,22 +199,159 @@ void Redstone::Engine::run()
 void Redstone::Engine::setMap(const Redstone::Map & map)
 {
 	this->_map = map;
+	this->_start();
+}
+
+
+/**
+ * @brief Set the map to use without copying it, reset ticks, and init
+ * @param map	The map to take, which is left empty
+ */
+void Redstone::Engine::setMap(Redstone::Map && map)
+{
+	this->_map = std::move(map);
+	this->_start();
+}
+
+
+/**
+ * @brief Set the map to use from a packed map, reset ticks, and init
+ * @param map	The packed map to unpack and use
+ */
+void Redstone::Engine::setMap(const Redstone::PackedMap & map)
+{
+	this->setMap(map.toMap());
+}
+
+
+/**
+ * @brief Reset ticks to zero, and init the map that was just set
+ */
+void Redstone::Engine::_start()
+{
+	const Map & map = this->_map;
 	this->_tickNumber = 0;
-	this->_updates = {};
-	this->_nextUpdates = {};
-
-	// We also need to set everything to update
-	Map::Size size = map.size();
-	Map::Coordinates coords;
-	for (coords.x = 0; coords.x != size.x; ++coords.x) {
-		for (coords.z = 0; coords.z != size.z; ++coords.z) {
-			for (coords.y = 0; coords.y != size.y; ++coords.y)
-				this->markNextUpdate(coords);
-		}
+	this->_updates.clear();
+	this->_tickOpen = false;
+	this->_scheduled.reset();
+	this->_indexBox = Map::Box(map.origin(), map.size());
+	this->_pending.assign(map.volume(), PENDING_NONE);
+	this->_laterDue.assign(map.volume(), 0);
+	this->_laterCount = 0;
+	this->_changes.clear();
+	this->_dustGraph.clear();
+	this->_suppressedUpdates = 0;
+	this->resetStats();
+	this->_restartCycle();
+
+	auto start = std::chrono::steady_clock::now();
+
+	// Only active components, and what's around them, can change on their
+	// own.  Everything else is left alone until they ask for it.
+	std::vector<Map::Coordinates> active;
+	map.forEach([&active](const Map::Coordinates & coords, const Component * comp) {
+		if (comp->isActive())
+			active.push_back(coords);
+	});
+
+	// Queue them going along y, then z, then x, like it always has
+	std::sort(active.begin(), active.end(),
+		[](const Map::Coordinates & a, const Map::Coordinates & b) {
+			if (a.x != b.x)
+				return a.x < b.x;
+			if (a.z != b.z)
+				return a.z < b.z;
+			return a.y < b.y;
+		});
+	for (auto & coords : active) {
+		this->markUpdate(coords);
+		this->_markSurrounding(coords);
 	}
+	this->_setupUpdates = this->_updates.size();
 
 	// And now run one tick to update it
 	this->run();
+
+	this->_setupTime = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - start);
+}
+
+
+/**
+ * @brief Move every waiting index over, if the map has been resized
+ */
+void Redstone::Engine::_checkLayout()
+{
+	const Map & map = this->_map;
+	const Map::Box & before = this->_indexBox;
+	if (map.origin().x == before.origin.x && map.origin().y == before.origin.y
+			&& map.origin().z == before.origin.z && map.size().x == before.size.x
+			&& map.size().y == before.size.y && map.size().z == before.size.z)
+		return;
+
+	// Take each index back to a location with the box it was taken in, and
+	// to an index again with the new one.  Returns false if it's gone.
+	size_t volume = before.size.x * before.size.y * before.size.z;
+	auto move = [&map, &before, volume](uint32_t & index) {
+		if (index >= volume)
+			return false;
+
+		size_t rest = index;
+		int x = static_cast<int>(rest % before.size.x);
+		rest /= before.size.x;
+		int y = static_cast<int>(rest % before.size.y);
+		int z = static_cast<int>(rest / before.size.y);
+		Map::Coordinates coords(
+			x + before.origin.x, y + before.origin.y, z + before.origin.z);
+		if (!map.contains(coords))
+			return false;
+
+		index = static_cast<uint32_t>(map.index(coords));
+		return true;
+	};
+
+	// The flags are set again from the lists they stand for, and from the
+	// old flags for the later wakes
+	std::vector<unsigned char> pending(map.volume(), PENDING_NONE);
+	std::vector<unsigned long long> laterDue(map.volume(), 0);
+	this->_pending.swap(pending);
+	this->_laterDue.swap(laterDue);
+	this->_laterCount = 0;
+
+	std::vector<uint32_t> queued;
+	queued.reserve(this->_updates.size());
+	for (; !this->_updates.empty(); this->_updates.pop())
+		queued.push_back(this->_updates.front());
+	for (auto index : queued) {
+		if (move(index)) {
+			this->_pending[index] |= PENDING_NOW;
+			this->_updates.push(index);
+		}
+	}
+
+	// Entries replaced by an earlier wake are moved too, and still dropped
+	// when they come due
+	this->_scheduled.rewrite(move);
+	for (uint32_t old = 0; old != pending.size(); ++old) {
+		uint32_t index = old;
+		if ((pending[old] & PENDING_LATER) && move(index)) {
+			this->_pending[index] |= PENDING_LATER;
+			this->_laterDue[index] = laterDue[old];
+			++ this->_laterCount;
+		}
+	}
+
+	auto gone = std::remove_if(this->_changes.begin(), this->_changes.end(),
+		[&move](uint32_t & index) { return !move(index); });
+	this->_changes.erase(gone, this->_changes.end());
+	for (auto index : this->_changes)
+		this->_pending[index] |= PENDING_CHANGED;
+
+	this->_dustGraph.reindex(map);
+
+	// The hash is keyed by index too
+	this->_indexBox = Map::Box(map.origin(), map.size());
+	this->_restartCycle();
 }
 
 
@@ -70,7 +362,15 @@ void Redstone::Engine::setMap(const Redstone::Map & map)
 void Redstone::Engine::markUpdate(
 	const Redstone::Map::Coordinates & coords)
 {
-	this->_updates.push(coords);
+	if (!this->_map.contains(coords))
+		return;
+
+	// Poked from outside, so the map may have been changed
+	if (!this->_inTick)
+		this->_restartCycle();
+
+	this->_checkLayout();
+	this->_markIndex(static_cast<uint32_t>(this->_map.index(coords)));
 }
 
 
@@ -81,6 +381,476 @@ void Redstone::Engine::markUpdate(
 void Redstone::Engine::markNextUpdate(
 	const Redstone::Map::Coordinates & coords)
 {
-	this->_nextUpdates.push(coords);
+	this->scheduleUpdate(coords, 1);
 }
 
+
+/**
+ * @brief Mark a position to be updated some ticks from now
+ * @param coords	The position to be updated
+ * @param delay	The number of ticks to wait, 1 being the next tick
+ */
+void Redstone::Engine::scheduleUpdate(
+	const Redstone::Map::Coordinates & coords,
+	unsigned delay)
+{
+	if (delay == 0) {
+		this->markUpdate(coords);
+		return;
+	}
+
+	if (!this->_map.contains(coords))
+		return;
+
+	if (!this->_inTick)
+		this->_restartCycle();
+
+	this->_checkLayout();
+
+	// Already waking up by then?  Otherwise the earlier wake replaces the
+	// later one, which is left in the wheel and dropped when it comes due.
+	uint32_t index = static_cast<uint32_t>(this->_map.index(coords));
+	unsigned long long due = this->_scheduled.now() + delay;
+	unsigned char & flags = this->_pending[index];
+	unsigned long long & waiting = this->_laterDue[index];
+	if (flags & PENDING_LATER) {
+		++ this->_suppressedUpdates;
+		if (waiting <= due)
+			return;
+	}
+	else {
+		flags |= PENDING_LATER;
+		++ this->_laterCount;
+	}
+	waiting = due;
+
+	this->_scheduled.schedule(index, delay);
+#ifndef REDSTONE_NO_STATS
+	++ this->_tickStats.laterUpdates;
+#endif
+}
+
+
+/**
+ * @brief Check whether a position is waiting for a later tick
+ * @param coords	The position to check
+ * @returns true if it has been scheduled and hasn't come due yet
+ */
+bool Redstone::Engine::isUpdateScheduled(
+	const Redstone::Map::Coordinates & coords)
+{
+	if (!this->_map.contains(coords))
+		return false;
+
+	this->_checkLayout();
+	return (this->_pending[this->_map.index(coords)] & PENDING_LATER) != 0;
+}
+
+
+/**
+ * @brief Get ready for a component to change another one
+ * @param coords	The location of the other component
+ * @returns What to pass to endChange
+ */
+unsigned Redstone::Engine::beginChange(
+	const Redstone::Map::Coordinates & coords)
+{
+	const Map & map = this->_map;
+	const Component * comp = map.contains(coords) ? map.get(coords) : nullptr;
+	if (comp == nullptr)
+		return 0;
+
+	if (this->_detectCycles)
+		this->_mapHash ^= _hashVoxel(map.index(coords), comp);
+	return this->_trackChanges ? comp->getVisibleState() : 0;
+}
+
+
+/**
+ * @brief Finish a change started with beginChange
+ * @param coords	The location of the other component
+ * @param visible	What beginChange returned
+ */
+void Redstone::Engine::endChange(
+	const Redstone::Map::Coordinates & coords,
+	unsigned visible)
+{
+	const Map & map = this->_map;
+	const Component * comp = map.contains(coords) ? map.get(coords) : nullptr;
+	if (comp == nullptr)
+		return;
+
+	this->_checkLayout();
+	size_t index = map.index(coords);
+	if (this->_detectCycles)
+		this->_mapHash ^= _hashVoxel(index, comp);
+	if (this->_trackChanges && comp->getVisibleState() != visible)
+		this->_recordChange(static_cast<uint32_t>(index));
+}
+
+
+/* Helper functions */
+
+
+/**
+ * @brief Mark the six locations around one to be updated
+ * @param coords	The location in the middle
+ */
+void Redstone::Engine::_markSurrounding(
+	const Redstone::Map::Coordinates & coords)
+{
+	static const int offsets[6][3] = {
+		{ -1, 0, 0 }, { 1, 0, 0 },
+		{ 0, 0, -1 }, { 0, 0, 1 },
+		{ 0, -1, 0 }, { 0, 1, 0 }
+	};
+
+	for (auto & offset : offsets) {
+		Map::Coordinates neighbor(
+			coords.x + offset[0], coords.y + offset[1], coords.z + offset[2]);
+		if (static_cast<const Map &>(this->_map).get(neighbor))
+			this->markUpdate(neighbor);
+	}
+}
+
+
+/**
+ * @brief Run the map for one tick
+ * @returns The number of components updated
+ */
+unsigned long long Redstone::Engine::_runTick()
+{
+	if (!this->_tickOpen)
+		this->_beginTick();
+
+	unsigned long long count = this->_processUpdates(
+		~0ull, std::chrono::steady_clock::time_point::max());
+
+	this->_endTick();
+	return count;
+}
+
+
+/**
+ * @brief Start a tick, bringing in the updates that are due
+ */
+void Redstone::Engine::_beginTick()
+{
+	this->_tickOpen = true;
+
+	this->_checkLayout();
+	if (this->_detectCycles && this->_hashStale)
+		this->_rehashMap();
+
+	// Bring in the updates that are due this tick, skipping any that
+	// were replaced by an earlier one
+	this->_scheduled.advance([this](uint32_t index) {
+		unsigned char & flags = this->_pending[index];
+		if (!(flags & PENDING_LATER) || this->_laterDue[index] != this->_scheduled.now())
+			return;
+
+		flags &= ~PENDING_LATER;
+		-- this->_laterCount;
+		this->_markIndex(index);
+	});
+}
+
+
+/**
+ * @brief Go through updates in the current tick
+ * @param maxUpdates	The most updates to take off the queue
+ * @param deadline	When to stop, checked every so often
+ * @returns The number of components updated
+ */
+unsigned long long Redstone::Engine::_processUpdates(
+	unsigned long long maxUpdates,
+	std::chrono::steady_clock::time_point deadline)
+{
+	unsigned long long count = 0;
+	unsigned long long taken = 0;
+	bool timed = deadline != std::chrono::steady_clock::time_point::max();
+	this->_inTick = true;
+
+	while (!this->_updates.empty() && taken != maxUpdates) {
+
+		// Looking at the clock isn't free, so don't do it every time
+		if (timed && (taken & 63) == 0 && taken != 0
+				&& std::chrono::steady_clock::now() >= deadline)
+			break;
+
+		// The last update may have grown the map
+		this->_checkLayout();
+
+		uint32_t index = this->_updates.front();
+		this->_updates.pop();
+		++taken;
+
+		// Clear the flag first, so it may ask to be updated again
+		this->_pending[index] &= ~PENDING_NOW;
+
+		Map::Coordinates coords = this->_map.coordinates(index);
+		Redstone::Component * comp = this->_map.get(coords);
+		if (comp == nullptr)
+			continue;
+
+		// Called with the component as its own class, so the calls on it
+		// aren't virtual (see KnownComponents)
+		auto updateOne = [&](auto & c) {
+			// Swap the old state out of the hash and the new one in, and
+			// note if anything that can be seen changed
+			if (this->_detectCycles)
+				this->_mapHash ^= _hashVoxel(index, &c);
+			unsigned visible = this->_trackChanges ? c.getVisibleState() : 0;
+#ifndef REDSTONE_NO_STATS
+			unsigned key = c.getStateKey();
+#endif
+
+			c.update(*this, coords);
+			++count;
+
+#ifndef REDSTONE_NO_STATS
+			++ this->_tickStats.updates[static_cast<int>(c.getId())];
+			if (c.getStateKey() == key)
+				++ this->_tickStats.noOpUpdates;
+#endif
+
+			if (this->_detectCycles)
+				this->_mapHash ^= _hashVoxel(index, &c);
+			if (this->_trackChanges && c.getVisibleState() != visible)
+				this->_recordChange(index);
+		};
+
+#ifdef REDSTONE_VIRTUAL_DISPATCH
+		updateOne(*comp);
+#else
+		KnownComponents::visit(*comp, updateOne);
+#endif
+	}
+
+	this->_inTick = false;
+	return count;
+}
+
+
+/**
+ * @brief Finish the current tick
+ */
+void Redstone::Engine::_endTick()
+{
+	// Increment tick number, and done!
+	++ this->_tickNumber;
+	this->_tickOpen = false;
+
+#ifndef REDSTONE_NO_STATS
+	this->_lastTickStats = this->_tickStats;
+	this->_totalStats += this->_tickStats;
+	this->_tickStats = Stats();
+#endif
+
+	if (this->_detectCycles)
+		this->_checkCycle();
+}
+
+
+/**
+ * @brief Run part of a tick, and finish it if the updates run out
+ * @param maxUpdates	The most updates to take off the queue
+ * @param deadline	When to stop, checked every so often
+ * @returns true if the tick was finished
+ */
+bool Redstone::Engine::_runPartialTick(
+	unsigned long long maxUpdates,
+	std::chrono::steady_clock::time_point deadline)
+{
+	if (!this->_tickOpen)
+		this->_beginTick();
+
+	this->_processUpdates(maxUpdates, deadline);
+	if (!this->_updates.empty())
+		return false;
+
+	this->_endTick();
+	return true;
+}
+
+
+/**
+ * @brief Run ticks, skipping those with nothing to do
+ * @param ticks	The most ticks to run
+ * @param untilStill	Whether to stop early once still
+ * @returns What happened in those ticks
+ */
+Redstone::Engine::RunStats Redstone::Engine::_runTicks(
+	int ticks,
+	bool untilStill)
+{
+	RunStats stats;
+
+	while (stats.ticks < ticks) {
+		if (untilStill && this->isStill())
+			break;
+
+		// Nothing to do until the next scheduled update, so jump to it
+		if (this->_updates.empty() && !this->_tickOpen && !this->_detectCycles) {
+			unsigned long long idle = ticks - stats.ticks;
+			if (!this->_scheduled.empty())
+				idle = std::min(idle, this->_scheduled.nextDue() - this->_scheduled.now() - 1);
+
+			if (idle) {
+				this->_scheduled.skip(idle);
+				this->_tickNumber += static_cast<int>(idle);
+				stats.ticks += static_cast<int>(idle);
+				continue;
+			}
+		}
+
+		stats.updates += this->_runTick();
+		++ stats.simulatedTicks;
+		++ stats.ticks;
+	}
+
+	return stats;
+}
+
+
+/**
+ * @brief Forget what has been seen, and look for a cycle again
+ */
+void Redstone::Engine::_restartCycle()
+{
+	this->_hashStale = true;
+	this->_cyclePower = 0;
+	this->_cycleLength = 0;
+	this->_period = 0;
+}
+
+
+/**
+ * @brief Hash the whole map from scratch
+ */
+void Redstone::Engine::_rehashMap()
+{
+	this->_mapHash = 0;
+
+	// Only look, so chunks shared with other maps aren't copied
+	const Map & map = this->_map;
+	map.forEach([this, &map](const Map::Coordinates & coords, const Component * comp) {
+		this->_mapHash ^= _hashVoxel(map.index(coords), comp);
+	});
+
+	this->_hashStale = false;
+}
+
+
+/**
+ * @brief Check the state at the end of a tick against earlier ones
+ */
+void Redstone::Engine::_checkCycle()
+{
+	if (this->_period)
+		return;
+
+	// The updates waiting are part of the state too, by how far off they
+	// are.  Adding keeps the order they are stored in from mattering.
+	// Entries that were replaced by an earlier wake aren't counted.
+	unsigned long long waiting = 0;
+	unsigned long long now = this->_scheduled.now();
+	this->_scheduled.forEach([&](uint32_t index, unsigned long long delay) {
+		if ((this->_pending[index] & PENDING_LATER) && this->_laterDue[index] == now + delay)
+			waiting += _mix(_mix(index) + delay);
+	});
+	unsigned long long hash = this->_mapHash ^ _mix(waiting);
+
+	// Brent's algorithm: compare against a saved state, and save a new one
+	// each time the distance to it reaches the next power of two
+	if (this->_cyclePower == 0) {
+		this->_savedHash = hash;
+		this->_cyclePower = 1;
+		this->_cycleLength = 0;
+		return;
+	}
+
+	++ this->_cycleLength;
+	if (hash == this->_savedHash) {
+		this->_period = this->_cycleLength;
+		return;
+	}
+
+	if (this->_cycleLength == this->_cyclePower) {
+		this->_savedHash = hash;
+		this->_cyclePower *= 2;
+		this->_cycleLength = 0;
+	}
+}
+
+
+/**
+ * @brief Hash the component at a location
+ * @param index	The map index of the location
+ * @param comp	The component there, or nullptr
+ * @returns The hash
+ */
+unsigned long long Redstone::Engine::_hashVoxel(
+	size_t index,
+	const Redstone::Component * comp)
+{
+	if (comp == nullptr)
+		return 0;
+
+	unsigned long long state = comp->getStateKey();
+	state = (state << 8) | static_cast<unsigned long long>(comp->getId());
+	return _mix(_mix(index) ^ state);
+}
+
+
+/**
+ * @brief Mix up the bits of a number
+ * @param value	The number to mix
+ * @returns The mixed number
+ */
+unsigned long long Redstone::Engine::_mix(unsigned long long value)
+{
+	// The splitmix64 finalizer
+	value += 0x9E3779B97F4A7C15ull;
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+	return value ^ (value >> 31);
+}
+
+
+/**
+ * @brief Add a location to the list of changes, unless it's already there
+ * @param index	The map index of the location
+ */
+void Redstone::Engine::_recordChange(uint32_t index)
+{
+	unsigned char & flags = this->_pending[index];
+	if (flags & PENDING_CHANGED)
+		return;
+
+	flags |= PENDING_CHANGED;
+	this->_changes.push_back(index);
+}
+
+
+/**
+ * @brief Queue a location to be updated this tick, unless it already is
+ * @param index	The map index of the location
+ */
+void Redstone::Engine::_markIndex(uint32_t index)
+{
+	// Already waiting in this tick?
+	unsigned char & flags = this->_pending[index];
+	if (flags & PENDING_NOW) {
+		++ this->_suppressedUpdates;
+		return;
+	}
+
+	flags |= PENDING_NOW;
+	this->_updates.push(index);
+
+#ifndef REDSTONE_NO_STATS
+	if (this->_updates.size() > this->_tickStats.peakQueue)
+		this->_tickStats.peakQueue = this->_updates.size();
+#endif
+}
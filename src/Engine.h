@@ -9,9 +9,14 @@
 #ifndef REDSTONE_ENGINE_H
 #define REDSTONE_ENGINE_H
 
-#include <queue>
+#include <chrono>
+#include <cstdint>
+#include <vector>
 
 #include "Map.h"
+#include "_bits/DustGraph.h"
+#include "_bits/RingBuffer.h"
+#include "_bits/TimingWheel.h"
 
 
 /* Redstone namespace */
@@ -21,6 +26,7 @@ namespace Redstone
 
 	/* Forward declarations */
 	class Component;
+	class PackedMap;
 
 
 	/**
@@ -31,19 +37,239 @@ namespace Redstone
 
 	public:
 
+		/* Types */
+
+		/**
+		 * @brief What happened during a batch of ticks
+		 */
+		struct RunStats
+		{
+			int ticks = 0;				/** ticks the clock moved forward */
+			int simulatedTicks = 0;		/** ticks that had updates to run */
+			unsigned long long updates = 0;	/** components updated */
+
+			/**
+			 * @brief Add on the stats of a later batch
+			 * @param b	The stats to add
+			 * @returns This
+			 */
+			RunStats & operator +=(const RunStats & b)
+			{
+				this->ticks += b.ticks;
+				this->simulatedTicks += b.simulatedTicks;
+				this->updates += b.updates;
+				return *this;
+			}
+		};
+
+
+		/**
+		 * @brief Room for each Component::ID in per-component counters
+		 */
+		static const int ID_SLOTS = Map::ID_SLOTS;
+
+		/**
+		 * @brief Counters of what the engine did
+		 *
+		 * These are all left at zero if REDSTONE_NO_STATS is defined.
+		 */
+		struct Stats
+		{
+			unsigned long long updates[ID_SLOTS] = {};	/** updates, by Component::ID */
+			unsigned long long noOpUpdates = 0;	/** updates that didn't change anything */
+			unsigned long long laterUpdates = 0;	/** requests for a later tick that were kept */
+			size_t peakQueue = 0;			/** longest the update queue got */
+
+			/**
+			 * @brief Get the number of updates of all components
+			 * @returns The total
+			 */
+			unsigned long long totalUpdates() const
+			{
+				unsigned long long total = 0;
+				for (auto count : this->updates)
+					total += count;
+				return total;
+			}
+
+			/**
+			 * @brief Add on the counters of a later tick
+			 * @param b	The counters to add
+			 * @returns This
+			 */
+			Stats & operator +=(const Stats & b)
+			{
+				for (int i = 0; i != ID_SLOTS; ++i)
+					this->updates[i] += b.updates[i];
+				this->noOpUpdates += b.noOpUpdates;
+				this->laterUpdates += b.laterUpdates;
+				if (b.peakQueue > this->peakQueue)
+					this->peakQueue = b.peakQueue;
+				return *this;
+			}
+		};
+
+
+		/**
+		 * @brief Heap memory held by an engine, in bytes
+		 */
+		struct MemoryUsage
+		{
+			Map::MemoryUsage map;		/** the map being run */
+			size_t updateQueue = 0;		/** the queue of updates for this tick */
+			size_t scheduled = 0;		/** updates waiting for later ticks */
+			size_t pending = 0;			/** the flags of which locations are queued */
+			size_t changes = 0;			/** the list of changed locations */
+			size_t dustGraph = 0;		/** the wires of dust that have been found */
+
+			/**
+			 * @brief Get the bytes of everything
+			 * @returns The total
+			 */
+			size_t total() const
+			{
+				return this->map.total() + this->updateQueue + this->scheduled
+					+ this->pending + this->changes + this->dustGraph;
+			}
+		};
+
+
+		/* Functions */
+
 		/**
 		 * @brief Run the map for one tick
+		 *
+		 * If a tick was started with runUpdates or runFor, this finishes it.
 		 */
 		void run();
 
+		/**
+		 * @brief Run part of a tick, up to a number of updates
+		 *
+		 * The next call picks up where this one left off.  The tick number
+		 * only goes up once the tick is finished.
+		 *
+		 * @param maxUpdates	The most updates to take off the queue
+		 * @returns true if the tick was finished
+		 */
+		bool runUpdates(unsigned long long maxUpdates);
+
+		/**
+		 * @brief Run part of a tick, for about some amount of time
+		 *
+		 * The clock is only checked every so often, so this may go a little
+		 * over.  Otherwise it works like runUpdates.
+		 *
+		 * @param budget	How long to run for
+		 * @returns true if the tick was finished
+		 */
+		bool runFor(std::chrono::microseconds budget);
+
+		/**
+		 * @brief Run the map for a number of ticks
+		 *
+		 * Ticks with nothing to do are skipped over without being run.
+		 *
+		 * @param ticks	The number of ticks to run
+		 * @returns What happened in those ticks
+		 */
+		RunStats runTicks(int ticks);
+
+		/**
+		 * @brief Run the map until it is still, or for a number of ticks
+		 *
+		 * Ticks with nothing to do are skipped over without being run.
+		 *
+		 * @param limit	The most ticks to run
+		 * @returns What happened in those ticks
+		 */
+		RunStats runUntilStill(int limit);
+
+		/**
+		 * @brief Run the map for a number of ticks, skipping repeated cycles
+		 *
+		 * Once the circuit is found to repeat itself, whole cycles are
+		 * jumped over and only the leftover ticks are run.  Cycle detection
+		 * is turned on while it runs, and left as it was afterwards.
+		 *
+		 * @param ticks	The number of ticks to run
+		 * @returns What happened in those ticks
+		 */
+		RunStats fastForward(int ticks);
+
+		/**
+		 * @brief Turn watching for repeated states on or off
+		 *
+		 * While on, the engine keeps a hash of the map and of the updates
+		 * waiting in it, and checks after each tick if it has been in the
+		 * same state before.  Idle ticks are run instead of skipped.
+		 *
+		 * @warning Changes made straight to the map (other than ones that
+		 *	ask for updates, like flipping a switch) are not noticed.
+		 * @param on	true to turn it on
+		 */
+		void setCycleDetection(bool on);
+
+		/**
+		 * @brief Get the length of the cycle the circuit is repeating
+		 * @returns The period in ticks, or 0 if none has been found
+		 */
+		int getPeriod() const
+		{
+			return this->_period;
+		}
+
+		/**
+		 * @brief Turn keeping a list of changed locations on or off
+		 *
+		 * While on, every location whose visible state changes during an
+		 * update is added to a list, once, until clearChanges is called.
+		 *
+		 * @warning Changes made from outside, like flipping a switch, are
+		 *	not listed.
+		 * @param on	true to turn it on
+		 */
+		void setChangeTracking(bool on);
+
+		/**
+		 * @brief Get the locations that changed since clearChanges
+		 *
+		 * Use getMap().coordinates() to turn the indices into locations.
+		 * If the map has grown, the indices are moved over first.
+		 *
+		 * @returns The map indices of the locations, in the order they first
+		 *	changed
+		 */
+		const std::vector<uint32_t> & getChanges();
+
+		/**
+		 * @brief Empty the list of changed locations
+		 */
+		void clearChanges();
+
 		/**
 		 * @brief Set the map to use, reset ticks to zero, and init
 		 * @param map	The map to use
 		 */
 		void setMap(const Map & map);
 
+		/**
+		 * @brief Set the map to use without copying it, reset ticks, and init
+		 * @param map	The map to take, which is left empty
+		 */
+		void setMap(Map && map);
+
+		/**
+		 * @brief Set the map to use from a packed map, reset ticks, and init
+		 * @param map	The packed map to unpack and use
+		 */
+		void setMap(const PackedMap & map);
+
 		/**
 		 * @brief Get the map currently being used
+		 * @warning Don't set anything outside of it through here.  Growing
+		 *	the map changes the index of every location, so give the bigger
+		 *	map to setMap instead.
 		 * @returns The map being used
 		 */
 		Map & getMap()
@@ -51,13 +277,23 @@ namespace Redstone
 			return this->_map;
 		}
 
+		/**
+		 * @brief Measure the heap memory the engine holds
+		 *
+		 * The queues keep their memory between ticks, so this is about the
+		 * most the engine has needed so far for this map.
+		 *
+		 * @returns The bytes, broken down by what they hold
+		 */
+		MemoryUsage memoryUsage() const;
+
 		/**
 		 * @brief Check whether the circuit has become "still" (no updates)
 		 * @returns True if there are to be more updates
 		 */
 		bool isStill() const
 		{
-			return this->_updates.empty() && this->_nextUpdates.empty();
+			return this->_updates.empty() && this->_laterCount == 0;
 		}
 
 		/**
@@ -69,6 +305,62 @@ namespace Redstone
 			return this->_tickNumber;
 		}
 
+		/**
+		 * @brief Get how many duplicate update requests were dropped
+		 *
+		 * A location that is already waiting to be updated is not queued a
+		 * second time, and a location waiting for a later tick is not
+		 * scheduled again for the same tick or after it.  This counts those
+		 * requests since setMap.
+		 *
+		 * @returns The number of suppressed update requests
+		 */
+		unsigned long long getSuppressedUpdates() const
+		{
+			return this->_suppressedUpdates;
+		}
+
+		/**
+		 * @brief Get the counters for the last finished tick
+		 * @returns The counters
+		 */
+		const Stats & getTickStats() const
+		{
+			return this->_lastTickStats;
+		}
+
+		/**
+		 * @brief Get the counters for every tick since setMap or resetStats
+		 * @returns The counters
+		 */
+		const Stats & getTotalStats() const
+		{
+			return this->_totalStats;
+		}
+
+		/**
+		 * @brief Set all the statistics back to zero
+		 */
+		void resetStats();
+
+		/**
+		 * @brief Get how long the last setMap took
+		 * @returns The time taken, including the first tick
+		 */
+		std::chrono::microseconds getSetupTime() const
+		{
+			return this->_setupTime;
+		}
+
+		/**
+		 * @brief Get how many locations the last setMap started off updating
+		 * @returns The number of locations queued for the first tick
+		 */
+		size_t getSetupUpdates() const
+		{
+			return this->_setupUpdates;
+		}
+
 
 	private:
 
@@ -87,16 +379,207 @@ namespace Redstone
 		 */
 		void markNextUpdate(const Map::Coordinates & coords);
 
+		/**
+		 * @brief Mark a position to be updated some ticks from now
+		 * @param coords	The position to be updated
+		 * @param delay	The number of ticks to wait, 1 being the next tick
+		 */
+		void scheduleUpdate(const Map::Coordinates & coords, unsigned delay);
+
+		/**
+		 * @brief Check whether a position is waiting for a later tick
+		 * @param coords	The position to check
+		 * @returns true if scheduleUpdate was called for it, and it hasn't
+		 *	come due yet
+		 */
+		bool isUpdateScheduled(const Map::Coordinates & coords);
+
+		/**
+		 * @brief Get ready for a component to change another one
+		 *
+		 * Only the component being updated is watched for changes.  Any
+		 * other component it changes has to be bracketed by beginChange
+		 * and endChange, so the hash and the change list stay right.
+		 *
+		 * @param coords	The location of the other component
+		 * @returns What to pass to endChange
+		 */
+		unsigned beginChange(const Map::Coordinates & coords);
+
+		/**
+		 * @brief Finish a change started with beginChange
+		 * @param coords	The location of the other component
+		 * @param visible	What beginChange returned
+		 */
+		void endChange(const Map::Coordinates & coords, unsigned visible);
+
+
+	private:
+
+		/* Helper functions */
+
+		/**
+		 * @brief Reset ticks to zero, and init the map that was just set
+		 */
+		void _start();
+
+		/**
+		 * @brief Move every waiting index over, if the map has been resized
+		 *
+		 * Indices change when the map grows, or when it is swapped out from
+		 * under us with getMap().  Locations that are no longer in the map
+		 * are dropped.
+		 */
+		void _checkLayout();
+
+		/**
+		 * @brief Queue a location to be updated this tick, unless it already is
+		 * @param index	The map index of the location
+		 */
+		void _markIndex(uint32_t index);
+
+		/**
+		 * @brief Add a location to the list of changes, unless it's already there
+		 * @param index	The map index of the location
+		 */
+		void _recordChange(uint32_t index);
+
+		/**
+		 * @brief Mark the six locations around one to be updated
+		 * @param coords	The location in the middle
+		 */
+		void _markSurrounding(const Map::Coordinates & coords);
+
+		/**
+		 * @brief Run the map for one tick
+		 * @returns The number of components updated
+		 */
+		unsigned long long _runTick();
+
+		/**
+		 * @brief Start a tick, bringing in the updates that are due
+		 */
+		void _beginTick();
+
+		/**
+		 * @brief Go through updates in the current tick
+		 * @param maxUpdates	The most updates to take off the queue
+		 * @param deadline	When to stop, checked every so often
+		 * @returns The number of components updated
+		 */
+		unsigned long long _processUpdates(
+			unsigned long long maxUpdates,
+			std::chrono::steady_clock::time_point deadline);
+
+		/**
+		 * @brief Finish the current tick
+		 */
+		void _endTick();
+
+		/**
+		 * @brief Run part of a tick, and finish it if the updates run out
+		 * @param maxUpdates	The most updates to take off the queue
+		 * @param deadline	When to stop, checked every so often
+		 * @returns true if the tick was finished
+		 */
+		bool _runPartialTick(
+			unsigned long long maxUpdates,
+			std::chrono::steady_clock::time_point deadline);
+
+		/**
+		 * @brief Run ticks, skipping those with nothing to do
+		 * @param ticks	The most ticks to run
+		 * @param untilStill	Whether to stop early once still
+		 * @returns What happened in those ticks
+		 */
+		RunStats _runTicks(int ticks, bool untilStill);
+
+		/**
+		 * @brief Forget what has been seen, and look for a cycle again
+		 */
+		void _restartCycle();
+
+		/**
+		 * @brief Hash the whole map from scratch
+		 */
+		void _rehashMap();
+
+		/**
+		 * @brief Check the state at the end of a tick against earlier ones
+		 */
+		void _checkCycle();
+
+		/**
+		 * @brief Hash the component at a location
+		 * @param index	The map index of the location
+		 * @param comp	The component there, or nullptr
+		 * @returns The hash
+		 */
+		static unsigned long long _hashVoxel(size_t index, const Component * comp);
+
+		/**
+		 * @brief Mix up the bits of a number
+		 * @param value	The number to mix
+		 * @returns The mixed number
+		 */
+		static unsigned long long _mix(unsigned long long value);
+
 
 	private:
 
+		/* Types */
+
+		/**
+		 * @brief Flags for the locations waiting in the queues or lists
+		 */
+		enum Pending : unsigned char
+		{
+			PENDING_NONE = 0,
+			PENDING_NOW = 1,		/** queued in _updates */
+			PENDING_CHANGED = 2,	/** listed in _changes */
+			PENDING_LATER = 4		/** waiting in _scheduled */
+		};
+
+
 		/* Data */
 
 		Map _map;
 		int _tickNumber = 0;
 
-		std::queue<Map::Coordinates> _updates;
-		std::queue<Map::Coordinates> _nextUpdates;
+		// Queued locations are kept by map index, so maps are limited to
+		// 2^32 voxels
+		RingBuffer<uint32_t> _updates;
+		TimingWheel<uint32_t> _scheduled;
+
+		Map::Box _indexBox;		// Where the map was when the indices were taken
+		std::vector<unsigned char> _pending;	// Pending flags, by map index
+		std::vector<unsigned long long> _laterDue;	// Tick each PENDING_LATER index is due, by map index
+		size_t _laterCount = 0;		// Indices that are PENDING_LATER
+		unsigned long long _suppressedUpdates = 0;
+
+		Stats _tickStats;		// Counting up in the current tick
+		Stats _lastTickStats;
+		Stats _totalStats;
+
+		bool _trackChanges = false;
+		std::vector<uint32_t> _changes;		// Changed locations, by map index
+
+		DustGraph _dustGraph;		// Wires found by RedstoneDust, kept between ticks
+
+		std::chrono::microseconds _setupTime{ 0 };
+		size_t _setupUpdates = 0;
+
+		bool _tickOpen = false;		// A tick has started but not finished
+		bool _inTick = false;		// Updates are being run right now
+
+		// Cycle detection (Brent's algorithm on the state hash)
+		bool _detectCycles = false;
+		bool _hashStale = true;			// The map hash needs redoing
+		unsigned long long _mapHash = 0;	// XOR of all voxel hashes
+		unsigned long long _savedHash = 0;	// State we are looking for again
+		int _cyclePower = 0;			// 0 until a state is saved
+		int _cycleLength = 0;			// Ticks since the saved state
+		int _period = 0;
 
 	};
 
@@ -9,23 +9,49 @@
 #include "Component.h"
 #include "Map.h"
 
+#include <algorithm>
+#include <atomic>
+
 
 /**
  * @brief Constructor
  * @param size	The size of the map
+ * @param layout	The order to keep voxels in
+ */
+Redstone::Map::Map(
+	const Redstone::Map::Size & size,
+	Redstone::Map::Layout layout) :
+	Map(Coordinates(), size, layout)
+{}
+
+
+/**
+ * @brief Construct with a box that doesn't start at zero
+ * @param origin	The lowest corner of the map
+ * @param size	The size of the map
+ * @param layout	The order to keep voxels in
  */
 Redstone::Map::Map(
-	const Redstone::Map::Size & size)
+	const Redstone::Map::Coordinates & origin,
+	const Redstone::Map::Size & size,
+	Redstone::Map::Layout layout) :
+	_layout(layout),
+	_origin(origin),
+	_size(size),
+	_arena(std::make_shared<Arena>())
 {
-	size_t volume = size.x * size.y * size.z;
-	this->_size = size;
+	if (this->volume() == 0)
+		return;
 
-	if (volume) {
-		this->_map = new Component*[volume];
-		memset(this->_map, 0, sizeof(Component) * volume);
-	}
-	else
-		this->_map = nullptr;
+	Coordinates lo(
+		origin.x >> CHUNK_BITS,
+		origin.y >> CHUNK_BITS,
+		origin.z >> CHUNK_BITS);
+	Coordinates hi(
+		(origin.x + static_cast<int>(size.x) - 1) >> CHUNK_BITS,
+		(origin.y + static_cast<int>(size.y) - 1) >> CHUNK_BITS,
+		(origin.z + static_cast<int>(size.z) - 1) >> CHUNK_BITS);
+	this->_layOut(lo, Size(hi.x - lo.x + 1, hi.y - lo.y + 1, hi.z - lo.z + 1));
 }
 
 
@@ -34,9 +60,36 @@ Redstone::Map::Map(
  * @param src	The other map to copy from
  */
 Redstone::Map::Map(
-	const Redstone::Map & src)
+	const Redstone::Map & src) :
+	_layout(src._layout),
+	_origin(src._origin),
+	_size(src._size),
+	_chunkOrigin(src._chunkOrigin),
+	_chunkCount(src._chunkCount),
+	_chunks(src._chunks),
+	_arena(std::make_shared<Arena>())
+{}
+
+
+/**
+ * @brief Move constructor
+ * @param src	The other map to take from, which is left empty
+ */
+Redstone::Map::Map(
+	Redstone::Map && src) noexcept :
+	_layout(src._layout),
+	_origin(src._origin),
+	_size(src._size),
+	_chunkOrigin(src._chunkOrigin),
+	_chunkCount(src._chunkCount),
+	_chunks(std::move(src._chunks)),
+	_arena(src._arena)
 {
-	this->_copy(src);
+	src._origin = Coordinates();
+	src._size = Size();
+	src._chunkOrigin = Coordinates();
+	src._chunkCount = Size();
+	src._chunks.clear();
 }
 
 
@@ -44,9 +97,7 @@ Redstone::Map::Map(
  * @brief We'll need a destructor
  */
 Redstone::Map::~Map()
-{
-	this->_cleanup();
-}
+{}
 
 
 /**
@@ -57,16 +108,14 @@ Redstone::Map::~Map()
 Redstone::Component * Redstone::Map::get(
 	const Redstone::Map::Coordinates & coords )
 {
-	if (this->_map == nullptr)
+	if (!this->contains(coords))
 		return nullptr;
-	if (coords.x < 0 || coords.y < 0 || coords.z < 0
-		|| coords.x >= static_cast<int>(this->_size.x)
-		|| coords.y >= static_cast<int>(this->_size.y)
-		|| coords.z >= static_cast<int>(this->_size.z))
+
+	size_t chunk = this->_chunkIndex(coords);
+	if (!this->_chunks[chunk])
 		return nullptr;
 
-	size_t offset = (coords.z * this->_size.y + coords.y) * this->_size.x + coords.x;
-	return this->_map[offset];
+	return this->_writable(chunk)->cells[_cellIndex(coords)];
 };
 
 
@@ -78,22 +127,40 @@ Redstone::Component * Redstone::Map::get(
 const Redstone::Component * Redstone::Map::get(
 	const Redstone::Map::Coordinates & coords) const
 {
-	if (this->_map == nullptr)
+	if (!this->contains(coords))
 		return nullptr;
-	if (coords.x < 0 || coords.y < 0 || coords.z < 0
-		|| coords.x >= static_cast<int>(this->_size.x)
-		|| coords.y >= static_cast<int>(this->_size.y)
-		|| coords.z >= static_cast<int>(this->_size.z))
+
+	const Chunk * chunk = this->_chunks[this->_chunkIndex(coords)].get();
+	if (chunk == nullptr)
 		return nullptr;
 
-	size_t offset = (coords.z * this->_size.y + coords.y) * this->_size.x + coords.x;
-	return this->_map[offset];
+	return chunk->cells[_cellIndex(coords)];
 };
 
 
+/**
+ * @brief Get a number that changes whenever a chunk's cells do
+ * @param coords	A location in the chunk
+ * @returns The stamp, 0 if there's no chunk there, or ~0 if another map
+ *	shares the chunk
+ */
+unsigned long long Redstone::Map::stamp(
+	const Redstone::Map::Coordinates & coords) const
+{
+	if (!this->contains(coords))
+		return 0;
+
+	const std::shared_ptr<Chunk> & slot = this->_chunks[this->_chunkIndex(coords)];
+	if (!slot)
+		return 0;
+	if (slot.use_count() != 1)
+		return ~0ull;
+	return slot->stamp;
+}
+
+
 /**
  * @brief Set the component at a certain location
- * @warning Will delete component if invalid coords
  * @param coords	The coordinates to put it at
  * @param component	The component to put there
  */
@@ -101,19 +168,24 @@ void Redstone::Map::set(
 	const Redstone::Map::Coordinates & coords,
 	Redstone::Component * component)
 {
-	if (this->_map == nullptr) {
-		delete component;
-		return;
+	if (!this->contains(coords)) {
+		if (component == nullptr)
+			return;
+		this->_grow(coords);
 	}
-	if (coords.x < 0 || coords.y < 0 || coords.z < 0
-		|| coords.x >= static_cast<int>(this->_size.x)
-		|| coords.y >= static_cast<int>(this->_size.y)
-		|| coords.z >= static_cast<int>(this->_size.z))
+
+	size_t index = this->_chunkIndex(coords);
+	if (component == nullptr && !this->_chunks[index])
 		return;
 
-	size_t offset = (coords.z * this->_size.y + coords.y) * this->_size.x + coords.x;
-	delete this->_map[offset];
-	this->_map[offset] = component;
+	Chunk * chunk = this->_writable(index);
+	Component *& cell = chunk->cells[_cellIndex(coords)];
+	chunk->release(cell);
+	cell = component;
+	chunk->touch();
+
+	if (component && this->_arena->contains(component))
+		chunk->keep(this->_arena);
 }
 
 
@@ -124,43 +196,644 @@ void Redstone::Map::set(
 Redstone::Map & Redstone::Map::operator =(
 	const Redstone::Map & src)
 {
-	this->_cleanup();
-	this->_copy(src);
+	this->_layout = src._layout;
+	this->_origin = src._origin;
+	this->_size = src._size;
+	this->_chunkOrigin = src._chunkOrigin;
+	this->_chunkCount = src._chunkCount;
+	this->_chunks = src._chunks;
+	this->_arena = std::make_shared<Arena>();
+	return *this;
+}
+
+
+/**
+ * @brief Move assignment operator
+ * @param src	The map to take from, which is left empty
+ */
+Redstone::Map & Redstone::Map::operator =(
+	Redstone::Map && src) noexcept
+{
+	if (this == &src)
+		return *this;
+
+	this->_layout = src._layout;
+	this->_origin = src._origin;
+	this->_size = src._size;
+	this->_chunkOrigin = src._chunkOrigin;
+	this->_chunkCount = src._chunkCount;
+	this->_chunks = std::move(src._chunks);
+	this->_arena = src._arena;
+
+	src._origin = Coordinates();
+	src._size = Size();
+	src._chunkOrigin = Coordinates();
+	src._chunkCount = Size();
+	src._chunks.clear();
 	return *this;
 }
 
 
+/**
+ * @brief Visit every location in a box, a chunk at a time
+ * @param box	The box to go through
+ * @param create	Whether to make chunks that are empty, or skip them
+ * @param visit	Called with the chunk, the cell and the coordinates
+ */
+template<typename Visit>
+void Redstone::Map::_forBox(
+	const Redstone::Map::Box & box,
+	bool create,
+	Visit visit)
+{
+	Coordinates hi(
+		box.origin.x + static_cast<int>(box.size.x) - 1,
+		box.origin.y + static_cast<int>(box.size.y) - 1,
+		box.origin.z + static_cast<int>(box.size.z) - 1);
+
+	Coordinates c;
+	for (c.z = box.origin.z >> CHUNK_BITS; c.z <= hi.z >> CHUNK_BITS; ++c.z) {
+		for (c.y = box.origin.y >> CHUNK_BITS; c.y <= hi.y >> CHUNK_BITS; ++c.y) {
+			for (c.x = box.origin.x >> CHUNK_BITS; c.x <= hi.x >> CHUNK_BITS; ++c.x) {
+				Coordinates corner(c.x * CHUNK_SIZE, c.y * CHUNK_SIZE, c.z * CHUNK_SIZE);
+				size_t index = this->_chunkIndex(corner);
+				if (!create && !this->_chunks[index])
+					continue;
+
+				// Just the part of the box in this chunk
+				Chunk & chunk = *this->_writable(index);
+				chunk.touch();
+				Coordinates lo(
+					std::max(box.origin.x, corner.x),
+					std::max(box.origin.y, corner.y),
+					std::max(box.origin.z, corner.z));
+				Coordinates top(
+					std::min(hi.x, corner.x + CHUNK_SIZE - 1),
+					std::min(hi.y, corner.y + CHUNK_SIZE - 1),
+					std::min(hi.z, corner.z + CHUNK_SIZE - 1));
+
+				Coordinates coords;
+				for (coords.z = lo.z; coords.z <= top.z; ++coords.z) {
+					for (coords.y = lo.y; coords.y <= top.y; ++coords.y) {
+						for (coords.x = lo.x; coords.x <= top.x; ++coords.x)
+							visit(chunk, chunk.cells[this->_cellIndex(coords)], coords);
+					}
+				}
+			}
+		}
+	}
+}
+
+
+/**
+ * @brief Fill a box with copies of a component
+ * @param box	The box to fill
+ * @param prototype	The component to copy, or nullptr to clear it
+ */
+void Redstone::Map::fill(
+	const Redstone::Map::Box & box,
+	const Redstone::Component * prototype)
+{
+	if (prototype == nullptr) {
+		this->clear(box);
+		return;
+	}
+	if (box.size.x == 0 || box.size.y == 0 || box.size.z == 0)
+		return;
+
+	this->_growTo(box);
+
+	// Get all the memory for the copies in one go
+	bool shared = prototype->isShared();
+	if (!shared && prototype->getSize())
+		this->_arena->reserve(box.size.x * box.size.y * box.size.z
+			* Arena::roundUp(prototype->getSize()));
+
+	this->_forBox(box, true, [this, prototype, shared](Chunk & chunk, Component *& cell, const Coordinates &) {
+		chunk.release(cell);
+		cell = this->_cloneHere(prototype);
+		if (!shared)
+			chunk.keep(this->_arena);
+	});
+}
+
+
+/**
+ * @brief Empty a box
+ * @param area	The box to empty
+ */
+void Redstone::Map::clear(
+	const Redstone::Map::Box & area)
+{
+	Box box = this->_clip(area);
+	if (box.size.x == 0)
+		return;
+
+	Coordinates hi(
+		box.origin.x + static_cast<int>(box.size.x) - 1,
+		box.origin.y + static_cast<int>(box.size.y) - 1,
+		box.origin.z + static_cast<int>(box.size.z) - 1);
+
+	// Drop the chunks that are inside the box whole
+	Coordinates c;
+	for (c.z = box.origin.z >> CHUNK_BITS; c.z <= hi.z >> CHUNK_BITS; ++c.z) {
+		for (c.y = box.origin.y >> CHUNK_BITS; c.y <= hi.y >> CHUNK_BITS; ++c.y) {
+			for (c.x = box.origin.x >> CHUNK_BITS; c.x <= hi.x >> CHUNK_BITS; ++c.x) {
+				Coordinates corner(c.x * CHUNK_SIZE, c.y * CHUNK_SIZE, c.z * CHUNK_SIZE);
+				if (this->_chunkWithin(corner, box))
+					this->_chunks[this->_chunkIndex(corner)].reset();
+			}
+		}
+	}
+
+	// And empty what's left one by one
+	this->_forBox(box, false, [](Chunk & chunk, Component *& cell, const Coordinates &) {
+		chunk.release(cell);
+		cell = nullptr;
+	});
+}
+
+
+/**
+ * @brief Copy a box of this map into a map
+ * @param area	The box to copy from
+ * @param dst	The map to copy into, which may be this one
+ * @param dstOrigin	Where the lowest corner of the box goes in dst
+ */
+void Redstone::Map::copyRegion(
+	const Redstone::Map::Box & area,
+	Redstone::Map & dst,
+	const Redstone::Map::Coordinates & dstOrigin) const
+{
+	// Copying onto ourselves, so read from a copy that won't change.  It
+	// shares our chunks, so this is cheap.
+	if (&dst == this) {
+		Map source(*this);
+		source.copyRegion(area, dst, dstOrigin);
+		return;
+	}
+
+	dst.clear(Box(dstOrigin, area.size));
+
+	Box box = this->_clip(area);
+	if (box.size.x == 0)
+		return;
+
+	Coordinates offset(
+		dstOrigin.x - area.origin.x,
+		dstOrigin.y - area.origin.y,
+		dstOrigin.z - area.origin.z);
+	dst._growTo(Box(Coordinates(
+		box.origin.x + offset.x, box.origin.y + offset.y, box.origin.z + offset.z), box.size));
+
+	// Whole chunks can be shared if they line up with the other map's
+	bool aligned = this->_layout == dst._layout && ((offset.x | offset.y | offset.z) & (CHUNK_SIZE - 1)) == 0;
+
+	Coordinates hi(
+		box.origin.x + static_cast<int>(box.size.x) - 1,
+		box.origin.y + static_cast<int>(box.size.y) - 1,
+		box.origin.z + static_cast<int>(box.size.z) - 1);
+
+	Coordinates c;
+	for (c.z = box.origin.z >> CHUNK_BITS; c.z <= hi.z >> CHUNK_BITS; ++c.z) {
+		for (c.y = box.origin.y >> CHUNK_BITS; c.y <= hi.y >> CHUNK_BITS; ++c.y) {
+			for (c.x = box.origin.x >> CHUNK_BITS; c.x <= hi.x >> CHUNK_BITS; ++c.x) {
+				Coordinates corner(c.x * CHUNK_SIZE, c.y * CHUNK_SIZE, c.z * CHUNK_SIZE);
+				const std::shared_ptr<Chunk> & slot = this->_chunks[this->_chunkIndex(corner)];
+				if (!slot)
+					continue;
+
+				// The chunk it lands on is empty, unless something is there
+				// outside the box
+				if (aligned && this->_chunkWithin(corner, box)) {
+					std::shared_ptr<Chunk> & target = dst._chunks[dst._chunkIndex(Coordinates(
+						corner.x + offset.x, corner.y + offset.y, corner.z + offset.z))];
+					if (!target) {
+						target = slot;
+						continue;
+					}
+				}
+
+				Coordinates lo(
+					std::max(box.origin.x, corner.x),
+					std::max(box.origin.y, corner.y),
+					std::max(box.origin.z, corner.z));
+				Coordinates top(
+					std::min(hi.x, corner.x + CHUNK_SIZE - 1),
+					std::min(hi.y, corner.y + CHUNK_SIZE - 1),
+					std::min(hi.z, corner.z + CHUNK_SIZE - 1));
+
+				Coordinates coords;
+				for (coords.z = lo.z; coords.z <= top.z; ++coords.z) {
+					for (coords.y = lo.y; coords.y <= top.y; ++coords.y) {
+						for (coords.x = lo.x; coords.x <= top.x; ++coords.x) {
+							const Component * comp = slot->cells[this->_cellIndex(coords)];
+							if (comp)
+								dst.set(Coordinates(coords.x + offset.x, coords.y + offset.y,
+									coords.z + offset.z), dst._cloneHere(comp));
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+
+/**
+ * @brief Measure the heap memory the map holds
+ * @returns The bytes, broken down by what they hold
+ */
+Redstone::Map::MemoryUsage Redstone::Map::memoryUsage() const
+{
+	MemoryUsage usage;
+	usage.chunkTable = this->_chunks.capacity() * sizeof(std::shared_ptr<Chunk>);
+
+	// Each arena is counted once, however many chunks keep it
+	std::vector<const Arena *> arenas;
+	auto addArena = [&arenas](const Arena * arena) {
+		if (std::find(arenas.begin(), arenas.end(), arena) == arenas.end())
+			arenas.push_back(arena);
+	};
+	if (this->_arena)
+		addArena(this->_arena.get());
+
+	size_t arenaUsed = 0;
+	for (auto & slot : this->_chunks) {
+		const Chunk * chunk = slot.get();
+		if (chunk == nullptr)
+			continue;
+
+		size_t bytes = sizeof(Chunk) + chunk->arenas.capacity() * sizeof(std::shared_ptr<Arena>);
+		usage.chunks += bytes;
+		if (slot.use_count() > 1)
+			usage.sharedChunks += bytes;
+		for (auto & arena : chunk->arenas)
+			addArena(arena.get());
+
+		for (const Component * comp : chunk->cells) {
+			if (comp == nullptr)
+				continue;
+
+			int id = static_cast<int>(comp->getId());
+			++ usage.counts[id];
+			if (comp->isShared())
+				continue;
+
+			size_t size = comp->getSize();
+			for (auto & arena : chunk->arenas) {
+				if (arena->contains(comp)) {
+					size = Arena::roundUp(size);
+					arenaUsed += size;
+					break;
+				}
+			}
+			usage.components[id] += size;
+		}
+	}
+
+	size_t capacity = 0;
+	for (auto arena : arenas)
+		capacity += arena->capacity();
+	if (capacity > arenaUsed)
+		usage.arenaUnused = capacity - arenaUsed;
+
+	return usage;
+}
+
+
+/* Cursors */
+
+
+/**
+ * @brief Constructor
+ * @param map	The map to look in
+ * @param coords	The location at the center
+ */
+Redstone::Map::Cursor::Cursor(
+	Redstone::Map & map,
+	const Redstone::Map::Coordinates & coords) :
+	_map(&map),
+	_coords(coords),
+	_local(
+		coords.x & (CHUNK_SIZE - 1),
+		coords.y & (CHUNK_SIZE - 1),
+		coords.z & (CHUNK_SIZE - 1)),
+	_chunk(nullptr)
+{
+	// Outside the map there's no chunk to read from, even if the
+	// neighbours are inside, so push the local coordinates out of range
+	if (!map.contains(coords)) {
+		this->_local = Coordinates(-CHUNK_SIZE, -CHUNK_SIZE, -CHUNK_SIZE);
+		return;
+	}
+
+	size_t chunk = map._chunkIndex(coords);
+	if (map._chunks[chunk])
+		this->_chunk = map._writable(chunk);
+}
+
+
+/* Chunks */
+
+
+/**
+ * @brief Constructor
+ */
+Redstone::Map::Chunk::Chunk()
+{
+	this->touch();
+}
+
+
+/**
+ * @brief Get rid of all the components
+ */
+Redstone::Map::Chunk::~Chunk()
+{
+	for (auto comp : this->cells)
+		this->release(comp);
+}
+
+
+/**
+ * @brief Give the chunk a new stamp, after its cells change
+ */
+void Redstone::Map::Chunk::touch()
+{
+	// Shared by every map, so a stamp is never handed out twice
+	static std::atomic<unsigned long long> next(1);
+	this->stamp = next.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+/**
+ * @brief Get rid of a component that is no longer in the chunk
+ * @param comp	The component, or nullptr
+ */
+void Redstone::Map::Chunk::release(
+	Redstone::Component * comp)
+{
+	if (comp == nullptr || comp->isShared())
+		return;
+
+	for (auto & arena : this->arenas) {
+		if (arena->contains(comp)) {
+			comp->~Component();
+			return;
+		}
+	}
+	delete comp;
+}
+
+
+/**
+ * @brief Keep an arena around for as long as the chunk is
+ * @param arena	The arena some of the components are in
+ */
+void Redstone::Map::Chunk::keep(
+	const std::shared_ptr<Redstone::Arena> & arena)
+{
+	for (auto & a : this->arenas) {
+		if (a == arena)
+			return;
+	}
+	this->arenas.push_back(arena);
+}
+
+
 /* Helper functions */
 
 
 /**
- * @brief Clean up the memory
+ * @brief Stretch a range of chunks to take in some more
+ * @param lo	The first chunk needed
+ * @param hi	The last chunk needed
+ * @param first	The first chunk in the range, updated
+ * @param count	The number of chunks in the range, updated
  */
-void Redstone::Map::_cleanup()
+void Redstone::Map::_stretchRange(
+	int lo,
+	int hi,
+	int & first,
+	size_t & count)
 {
-	size_t volume = this->_size.x * this->_size.y * this->_size.z;
-	for (auto v = this->_map; v != this->_map + volume; ++v)
-		delete *v;
-	delete[] this->_map;
-	this->_map = nullptr;	// redundancy, just in case
+	if (count == 0) {
+		first = lo;
+		count = hi - lo + 1;
+		return;
+	}
+
+	int last = first + static_cast<int>(count) - 1;
+	if (lo < first)
+		first = std::min(lo, first - static_cast<int>(count));
+	if (hi > last)
+		last = std::max(hi, last + static_cast<int>(count));
+	count = last - first + 1;
 }
 
 
 /**
- * @brief Copy another Map over
- * @warning Assumes _map is nullptr
+ * @brief Get the lowest corner of a chunk
+ * @param chunk	The index of the chunk in _chunks
+ * @returns The coordinates of the corner
  */
-void Redstone::Map::_copy(
-	const Redstone::Map & src)
+Redstone::Map::Coordinates Redstone::Map::_chunkCorner(
+	size_t chunk) const
 {
-	size_t volume = src._size.x * src._size.y * src._size.z;
-	this->_size = src._size;
-	if (volume) {
-		this->_map = new Component*[volume];
-		for (auto d = this->_map, s = src._map; d != this->_map + volume; ++d, ++s)
-			*d = (*s)? (*s)->clone() : nullptr;
+	int x = static_cast<int>(chunk % this->_chunkCount.x);
+	chunk /= this->_chunkCount.x;
+	int y = static_cast<int>(chunk % this->_chunkCount.y);
+	int z = static_cast<int>(chunk / this->_chunkCount.y);
+	return Coordinates(
+		(x + this->_chunkOrigin.x) * CHUNK_SIZE,
+		(y + this->_chunkOrigin.y) * CHUNK_SIZE,
+		(z + this->_chunkOrigin.z) * CHUNK_SIZE);
+}
+
+
+/**
+ * @brief Get a chunk that only this map has, for changing
+ * @param chunk	The index of the chunk
+ * @returns The chunk, copied or made first if need be
+ */
+Redstone::Map::Chunk * Redstone::Map::_writable(
+	size_t chunk)
+{
+	std::shared_ptr<Chunk> & slot = this->_chunks[chunk];
+	if (!slot) {
+		slot = std::make_shared<Chunk>();
+		return slot.get();
+	}
+	if (slot.use_count() == 1)
+		return slot.get();
+
+	// Someone else has it too, so copy it before it changes
+	auto copy = std::make_shared<Chunk>();
+	copy->arenas.push_back(this->_arena);
+
+	size_t bytes = 0;
+	for (auto comp : slot->cells) {
+		if (comp && !comp->isShared())
+			bytes += Arena::roundUp(comp->getSize());
 	}
-	else
-		this->_map = nullptr;
+	if (bytes)
+		this->_arena->reserve(bytes);
+
+	for (size_t i = 0; i != CHUNK_VOLUME; ++i) {
+		if (slot->cells[i])
+			copy->cells[i] = this->_cloneHere(slot->cells[i]);
+	}
+
+	slot = copy;
+	return slot.get();
+}
+
+
+/**
+ * @brief Make a copy of a component to keep in this map
+ * @param comp	The component to copy
+ * @returns The copy, made in the arena if it can be
+ */
+Redstone::Component * Redstone::Map::_cloneHere(
+	const Redstone::Component * comp)
+{
+	// Shared components are never changed through a map, so they aren't
+	// really const
+	if (comp->isShared())
+		return const_cast<Component *>(comp);
+
+	size_t size = comp->getSize();
+	Component * copy = size ? comp->cloneAt(this->_arena->allocate(size)) : nullptr;
+	return copy ? copy : comp->clone();
+}
+
+
+/**
+ * @brief Make the map bigger so it takes in a box
+ * @param box	The box to take in, which isn't empty
+ */
+void Redstone::Map::_growTo(
+	const Redstone::Map::Box & box)
+{
+	Coordinates hi(
+		box.origin.x + static_cast<int>(box.size.x) - 1,
+		box.origin.y + static_cast<int>(box.size.y) - 1,
+		box.origin.z + static_cast<int>(box.size.z) - 1);
+	if (!this->contains(box.origin))
+		this->_grow(box.origin);
+	if (!this->contains(hi))
+		this->_grow(hi);
 }
 
+
+/**
+ * @brief Get the part of a box that is inside the map
+ * @param box	The box to cut down
+ * @returns The part inside, which may be empty
+ */
+Redstone::Map::Box Redstone::Map::_clip(
+	const Redstone::Map::Box & box) const
+{
+	if (this->volume() == 0 || box.size.x == 0 || box.size.y == 0 || box.size.z == 0)
+		return Box();
+
+	Coordinates lo(
+		std::max(box.origin.x, this->_origin.x),
+		std::max(box.origin.y, this->_origin.y),
+		std::max(box.origin.z, this->_origin.z));
+	Coordinates hi(
+		std::min(box.origin.x + static_cast<int>(box.size.x),
+			this->_origin.x + static_cast<int>(this->_size.x)) - 1,
+		std::min(box.origin.y + static_cast<int>(box.size.y),
+			this->_origin.y + static_cast<int>(this->_size.y)) - 1,
+		std::min(box.origin.z + static_cast<int>(box.size.z),
+			this->_origin.z + static_cast<int>(this->_size.z)) - 1);
+	if (lo.x > hi.x || lo.y > hi.y || lo.z > hi.z)
+		return Box();
+
+	return Box(lo, Size(hi.x - lo.x + 1, hi.y - lo.y + 1, hi.z - lo.z + 1));
+}
+
+
+/**
+ * @brief Check whether the part of a chunk inside the map is in a box
+ * @param corner	The lowest corner of the chunk
+ * @param box	The box to check against
+ * @returns true if everything the chunk can hold is in the box
+ */
+bool Redstone::Map::_chunkWithin(
+	const Redstone::Map::Coordinates & corner,
+	const Redstone::Map::Box & box) const
+{
+	Box part = this->_clip(Box(corner, Size(CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE)));
+	if (part.size.x == 0)
+		return true;
+
+	return part.origin.x >= box.origin.x && part.origin.y >= box.origin.y
+		&& part.origin.z >= box.origin.z
+		&& part.origin.x + static_cast<int>(part.size.x) <= box.origin.x + static_cast<int>(box.size.x)
+		&& part.origin.y + static_cast<int>(part.size.y) <= box.origin.y + static_cast<int>(box.size.y)
+		&& part.origin.z + static_cast<int>(part.size.z) <= box.origin.z + static_cast<int>(box.size.z);
+}
+
+
+/**
+ * @brief Make the map bigger so it takes in a location
+ * @param coords	The coordinates to take in
+ */
+void Redstone::Map::_grow(
+	const Redstone::Map::Coordinates & coords)
+{
+	Coordinates lo = coords, hi = coords;
+	if (this->volume()) {
+		lo = Coordinates(
+			std::min(coords.x, this->_origin.x),
+			std::min(coords.y, this->_origin.y),
+			std::min(coords.z, this->_origin.z));
+		hi = Coordinates(
+			std::max(coords.x, this->_origin.x + static_cast<int>(this->_size.x) - 1),
+			std::max(coords.y, this->_origin.y + static_cast<int>(this->_size.y) - 1),
+			std::max(coords.z, this->_origin.z + static_cast<int>(this->_size.z) - 1));
+	}
+	this->_origin = lo;
+	this->_size = Size(hi.x - lo.x + 1, hi.y - lo.y + 1, hi.z - lo.z + 1);
+
+	// Lay out more chunks if they don't cover it already
+	Coordinates chunkOrigin = this->_chunkOrigin;
+	Size chunkCount = this->_chunkCount;
+	_stretchRange(lo.x >> CHUNK_BITS, hi.x >> CHUNK_BITS, chunkOrigin.x, chunkCount.x);
+	_stretchRange(lo.y >> CHUNK_BITS, hi.y >> CHUNK_BITS, chunkOrigin.y, chunkCount.y);
+	_stretchRange(lo.z >> CHUNK_BITS, hi.z >> CHUNK_BITS, chunkOrigin.z, chunkCount.z);
+	if (chunkCount.x != this->_chunkCount.x || chunkCount.y != this->_chunkCount.y
+			|| chunkCount.z != this->_chunkCount.z)
+		this->_layOut(chunkOrigin, chunkCount);
+}
+
+
+/**
+ * @brief Lay out the chunks again over a new range of chunks
+ * @param chunkOrigin	The lowest chunk, in chunks
+ * @param chunkCount	The number of chunks along each side
+ */
+void Redstone::Map::_layOut(
+	const Redstone::Map::Coordinates & chunkOrigin,
+	const Redstone::Map::Size & chunkCount)
+{
+	std::vector<std::shared_ptr<Chunk>> chunks(chunkCount.x * chunkCount.y * chunkCount.z);
+
+	for (size_t c = 0; c != this->_chunks.size(); ++c) {
+		if (!this->_chunks[c])
+			continue;
+
+		Coordinates corner = this->_chunkCorner(c);
+		size_t x = (corner.x >> CHUNK_BITS) - chunkOrigin.x;
+		size_t y = (corner.y >> CHUNK_BITS) - chunkOrigin.y;
+		size_t z = (corner.z >> CHUNK_BITS) - chunkOrigin.z;
+		chunks[(z * chunkCount.y + y) * chunkCount.x + x] = std::move(this->_chunks[c]);
+	}
+
+	this->_chunks.swap(chunks);
+	this->_chunkOrigin = chunkOrigin;
+	this->_chunkCount = chunkCount;
+}
@@ -12,6 +12,12 @@
 
 
 #include <cstdlib>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "_bits/Arena.h"
 
 
 /* Redstone namespace */
@@ -28,6 +34,15 @@ namespace Redstone
 	*
 	* This class is a convenient holder for components in the world.
 	*
+	* The voxels are kept in 16x16x16 chunks, and a chunk is only allocated
+	* once something is put in it.  The map covers a box that starts at
+	* origin() and grows to take in anything set outside of it, negative
+	* coordinates and all.
+	*
+	* Copies of a map share their chunks until one of them changes a chunk
+	* or asks for a component in it that it could change.  Only then is that
+	* chunk copied, so copying a map is cheap.
+	*
 	*/
 	class Map
 	{
@@ -71,14 +86,85 @@ namespace Redstone
 			DOWN	/** towards -y */
 		};
 
+		/**
+		 * @brief A box of locations
+		 */
+		struct Box
+		{
+			Coordinates origin;	/** the lowest corner */
+			Size size;
+
+			Box() {}
+			Box(const Coordinates & _origin, const Size & _size) : origin(_origin), size(_size) {}
+		};
+
+		class Cursor;
+
+		/**
+		 * @brief Orders for the voxels inside a chunk
+		 */
+		enum class Layout {
+			LINEAR,	/** rows along x, then y, then z */
+			MORTON	/** Z-order, so neighbours along y and z are close by too */
+		};
+
+		/**
+		 * @brief Room for each Component::ID in per-component counters
+		 */
+		static const int ID_SLOTS = 32;
+
+		/**
+		 * @brief Chunks are 2^CHUNK_BITS locations along each side
+		 */
+		static const int CHUNK_BITS = 4;
+
+		/**
+		 * @brief Heap memory held by a map, in bytes
+		 *
+		 * Chunks shared with copies of the map are counted in full here and
+		 * in each copy.  sharedChunks says how much of that there is.
+		 */
+		struct MemoryUsage
+		{
+			size_t components[ID_SLOTS] = {};	/** bytes of components, by Component::ID */
+			size_t counts[ID_SLOTS] = {};	/** number of components, by Component::ID */
+			size_t chunks = 0;			/** bytes of the chunks' tables of components */
+			size_t chunkTable = 0;		/** bytes of the table of chunks */
+			size_t arenaUnused = 0;		/** bytes of arenas not taken by live components */
+			size_t sharedChunks = 0;	/** bytes of chunks that other maps use too */
+
+			/**
+			 * @brief Get the bytes of all components
+			 * @returns The total
+			 */
+			size_t totalComponents() const
+			{
+				size_t total = 0;
+				for (auto bytes : this->components)
+					total += bytes;
+				return total;
+			}
+
+			/**
+			 * @brief Get the bytes of everything
+			 * @returns The total
+			 */
+			size_t total() const
+			{
+				return this->totalComponents() + this->chunks + this->chunkTable
+					+ this->arenaUnused;
+			}
+		};
+
 
 		/* Functions */
 
 		/**
 		 * @brief Constructor
 		 * @param size	The size of the map
+		 * @param layout	The order to keep voxels in
 		 */
-		Map(const Size & size = Size());
+		Map(const Size & size = Size(), Layout layout = Layout::LINEAR);
 
 		/**
 		 * @brief Construct with a freakin' map size!
@@ -90,17 +176,49 @@ namespace Redstone
 			Map(Size(width, depth, height))
 		{}
 
+		/**
+		 * @brief Construct with a box that doesn't start at zero
+		 * @param origin	The lowest corner of the map
+		 * @param size	The size of the map
+		 * @param layout	The order to keep voxels in
+		 */
+		Map(const Coordinates & origin, const Size & size, Layout layout = Layout::LINEAR);
+
 		/**
 		 * @brief Copy constructor
 		 * @param src	The other map to copy from
 		 */
 		Map(const Map & src);
 
+		/**
+		 * @brief Move constructor
+		 * @param src	The other map to take from, which is left empty
+		 */
+		Map(Map && src) noexcept;
+
 		/**
 		 * @brief We'll need a destructor
 		 */
 		~Map();
 
+		/**
+		 * @brief Get the order voxels are kept in
+		 * @returns The layout chosen when the map was made
+		 */
+		Layout layout() const
+		{
+			return this->_layout;
+		}
+
+		/**
+		 * @brief Get the lowest corner of the map
+		 * @returns The coordinates of the corner
+		 */
+		const Coordinates & origin() const
+		{
+			return this->_origin;
+		}
+
 		/**
 		 * @brief Get the size of the map
 		 * @returns The size of the map
@@ -110,8 +228,73 @@ namespace Redstone
 			return this->_size;
 		}
 
+		/**
+		 * @brief Get the number of voxels in the map
+		 * @returns The width times the height times the depth
+		 */
+		size_t volume() const
+		{
+			return this->_size.x * this->_size.y * this->_size.z;
+		}
+
+		/**
+		 * @brief Check whether some coordinates are inside the map
+		 * @param coords	The coordinates to test
+		 * @returns true if they are inside the map
+		 */
+		bool contains(const Coordinates & coords) const
+		{
+			return coords.x >= this->_origin.x && coords.y >= this->_origin.y
+				&& coords.z >= this->_origin.z
+				&& coords.x - this->_origin.x < static_cast<int>(this->_size.x)
+				&& coords.y - this->_origin.y < static_cast<int>(this->_size.y)
+				&& coords.z - this->_origin.z < static_cast<int>(this->_size.z);
+		}
+
+		/**
+		 * @brief Get the linear index of a location
+		 * @warning Assumes the coordinates are inside the map.  Indices
+		 *	change when the map grows.
+		 * @param coords	The coordinates to convert
+		 * @returns The index of the location, between 0 and volume()
+		 */
+		size_t index(const Coordinates & coords) const
+		{
+			return ((coords.z - this->_origin.z) * this->_size.y
+				+ (coords.y - this->_origin.y)) * this->_size.x
+				+ (coords.x - this->_origin.x);
+		}
+
+		/**
+		 * @brief Get the location of a linear index
+		 * @warning Assumes the index is less than volume()
+		 * @param index	The index to convert
+		 * @returns The coordinates of the location
+		 */
+		Coordinates coordinates(size_t index) const
+		{
+			int x = static_cast<int>(index % this->_size.x);
+			index /= this->_size.x;
+			int y = static_cast<int>(index % this->_size.y);
+			int z = static_cast<int>(index / this->_size.y);
+			return Coordinates(
+				x + this->_origin.x, y + this->_origin.y, z + this->_origin.z);
+		}
+
+		/**
+		 * @brief Measure the heap memory the map holds
+		 *
+		 * Shared components (see Component::isShared) are counted but take
+		 * no bytes, since every map uses the same one.
+		 *
+		 * @returns The bytes, broken down by what they hold
+		 */
+		MemoryUsage memoryUsage() const;
+
 		/**
 		 * @brief Get the component at a certain location
+		 * @note This copies the chunk first if another map shares it.  Use
+		 *	the const version to only look.
 		 * @param coords	The coordinates to look at
 		 * @returns A pointer to the component there, or nullptr
 		 */
@@ -124,42 +307,426 @@ namespace Redstone
 		 */
 		const Component * get(const Coordinates & coords) const;
 
+		/**
+		 * @brief Get a number that changes whenever a chunk's cells do
+		 *
+		 * Putting a component in the chunk around a location, taking one
+		 * out, or copying the chunk away from another map gives it a new
+		 * stamp that no chunk has had before.  Something that remembers
+		 * what is around a location can keep the stamp, and trust what it
+		 * remembers for as long as the stamp is the same.  Changes to the
+		 * state of the components themselves don't count.
+		 *
+		 * @param coords	A location in the chunk
+		 * @returns The stamp, 0 if there's no chunk there, or ~0 if
+		 *	another map shares the chunk
+		 */
+		unsigned long long stamp(const Coordinates & coords) const;
+
 		/**
 		 * @brief Set the component at a certain location
+		 *
+		 * If the location is outside the map, the map grows to take it in.
+		 *
 		 * @warning Let the class handle deallocation!
+		 * @note Shared components (see Component::isShared) are never deleted
 		 * @param coords	The coordinates for it to be at
 		 * @param component	The component to put there
 		 */
 		void set(const Coordinates & coords, Component * component);
 
+		/**
+		 * @brief Fill a box with copies of a component
+		 *
+		 * The map grows to take in the box.  All the copies are made in one
+		 * go, and a shared component is just put everywhere.
+		 *
+		 * @param box	The box to fill
+		 * @param prototype	The component to copy, or nullptr to clear it
+		 */
+		void fill(const Box & box, const Component * prototype);
+
+		/**
+		 * @brief Empty a box
+		 *
+		 * Chunks that are inside the box are dropped whole.
+		 *
+		 * @param box	The box to empty
+		 */
+		void clear(const Box & box);
+
+		/**
+		 * @brief Copy a box of this map into a map
+		 *
+		 * Empty locations are copied too, so the box ends up the same in
+		 * both.  If the box is moved by a multiple of 16 along each axis,
+		 * chunks inside it are shared instead of copied.
+		 *
+		 * @param box	The box to copy from
+		 * @param dst	The map to copy into, which may be this one
+		 * @param dstOrigin	Where the lowest corner of the box goes in dst
+		 */
+		void copyRegion(const Box & box, Map & dst, const Coordinates & dstOrigin) const;
+
+		/**
+		 * @brief Visit every component in the map
+		 *
+		 * Empty chunks are skipped over, so this is much faster than looking
+		 * at every location of a sparse map.
+		 *
+		 * @param visit	Called with the coordinates and the component
+		 * @tparam Visit	void(const Coordinates &, const Component *)
+		 */
+		template<typename Visit>
+		void forEach(Visit visit) const
+		{
+			for (size_t c = 0; c != this->_chunks.size(); ++c) {
+				const Chunk * chunk = this->_chunks[c].get();
+				if (chunk)
+					this->_visitChunk(*chunk, this->_chunkCorner(c), visit);
+			}
+		}
+
+		/**
+		 * @brief Visit every component in the map, to change them
+		 * @note Chunks shared with another map are copied first
+		 * @param visit	Called with the coordinates and the component
+		 * @tparam Visit	void(const Coordinates &, Component *)
+		 */
+		template<typename Visit>
+		void forEach(Visit visit)
+		{
+			for (size_t c = 0; c != this->_chunks.size(); ++c) {
+				if (this->_chunks[c])
+					this->_visitChunk(*this->_writable(c), this->_chunkCorner(c), visit);
+			}
+		}
+
+		/**
+		 * @brief Make a new component in the map's own memory
+		 *
+		 * This is much faster than new for loading big maps, and the memory
+		 * is all freed at once when no map uses it any more.  The memory of
+		 * a component that is replaced is not reused until then.
+		 *
+		 * @warning Only set it in this map, and don't delete it!
+		 * @param args	The arguments for the component's constructor
+		 * @tparam T	The type of component to make
+		 * @returns The new component
+		 */
+		template<typename T, typename... Args>
+		T * make(Args &&... args)
+		{
+			return new (this->_arena->allocate(sizeof(T))) T(std::forward<Args>(args)...);
+		}
+
 		/**
 		 * @brief Assignment operator
 		 * @param src	The map to copy from
 		 */
 		Map & operator = (const Map & src);
 
+		/**
+		 * @brief Move assignment operator
+		 * @param src	The map to take from, which is left empty
+		 */
+		Map & operator = (Map && src) noexcept;
+
 
 	private:
 
+		/* Constants */
+
+		static const int CHUNK_SIZE = 1 << CHUNK_BITS;		// Width of a chunk
+		static const size_t CHUNK_VOLUME = 1 << (3 * CHUNK_BITS);
+
+
+		/* Types */
+
+		/**
+		 * @brief A cube of voxels that copies of a map can share
+		 */
+		struct Chunk
+		{
+			Component * cells[CHUNK_VOLUME] = {};	// In the order of the Layout
+			std::vector<std::shared_ptr<Arena>> arenas;	// Where its components were made
+			unsigned long long stamp;		// New whenever the cells change
+
+			/**
+			 * @brief Constructor
+			 */
+			Chunk();
+
+			/**
+			 * @brief Get rid of all the components
+			 */
+			~Chunk();
+
+			/**
+			 * @brief Give the chunk a new stamp, after its cells change
+			 */
+			void touch();
+
+			/**
+			 * @brief Get rid of a component that is no longer in the chunk
+			 * @param comp	The component, or nullptr
+			 */
+			void release(Component * comp);
+
+			/**
+			 * @brief Keep an arena around for as long as the chunk is
+			 * @param arena	The arena some of the components are in
+			 */
+			void keep(const std::shared_ptr<Arena> & arena);
+		};
+
+
 		/* Helper functions */
 
 		/**
-		 * @brief Clean up the memory
+		 * @brief Get the chunk a location is in
+		 * @warning Assumes the coordinates are inside the map
+		 * @param coords	The coordinates of the location
+		 * @returns The index of the chunk in _chunks
 		 */
-		void _cleanup();
+		size_t _chunkIndex(const Coordinates & coords) const
+		{
+			return ((static_cast<size_t>((coords.z >> CHUNK_BITS) - this->_chunkOrigin.z)
+				* this->_chunkCount.y
+				+ ((coords.y >> CHUNK_BITS) - this->_chunkOrigin.y))
+				* this->_chunkCount.x
+				+ ((coords.x >> CHUNK_BITS) - this->_chunkOrigin.x));
+		}
 
 		/**
-		 * @brief Copy another Map over
-		 * @warning Assumes _map is nullptr
+		 * @brief Get where a location is inside its chunk
+		 * @param coords	The coordinates of the location
+		 * @returns The index of the cell in the chunk
 		 */
-		void _copy(const Map & src);
+		size_t _cellIndex(const Coordinates & coords) const
+		{
+			return this->_localIndex(
+				coords.x & (CHUNK_SIZE - 1),
+				coords.y & (CHUNK_SIZE - 1),
+				coords.z & (CHUNK_SIZE - 1));
+		}
+
+		/**
+		 * @brief Spread out the bits of a coordinate for a Morton index
+		 * @param v	The coordinate inside a chunk, 0 to 15
+		 * @returns The bits of v moved to bits 0, 3, 6 and 9
+		 */
+		static size_t _spread(size_t v)
+		{
+			v = (v | (v << 4)) & 0x0C3;
+			return (v | (v << 2)) & 0x249;
+		}
+
+		/**
+		 * @brief Get the lowest corner of a chunk
+		 * @param chunk	The index of the chunk in _chunks
+		 * @returns The coordinates of the corner
+		 */
+		Coordinates _chunkCorner(size_t chunk) const;
+
+		/**
+		 * @brief Visit every component in a chunk
+		 * @param chunk	The chunk to look through
+		 * @param corner	The lowest corner of the chunk
+		 * @param visit	Called with the coordinates and the component
+		 * @tparam C	Chunk or const Chunk
+		 * @tparam Visit	The type of visit
+		 */
+		template<typename C, typename Visit>
+		void _visitChunk(C & chunk, const Coordinates & corner, Visit & visit) const
+		{
+			Coordinates coords;
+			for (coords.z = corner.z; coords.z != corner.z + CHUNK_SIZE; ++coords.z) {
+				for (coords.y = corner.y; coords.y != corner.y + CHUNK_SIZE; ++coords.y) {
+					for (coords.x = corner.x; coords.x != corner.x + CHUNK_SIZE; ++coords.x) {
+						auto comp = chunk.cells[this->_cellIndex(coords)];
+						if (comp)
+							visit(coords, comp);
+					}
+				}
+			}
+		}
+
+		/**
+		 * @brief Get where a location is inside its chunk
+		 * @param x	The x coordinate inside the chunk, 0 to 15
+		 * @param y	The y coordinate inside the chunk, 0 to 15
+		 * @param z	The z coordinate inside the chunk, 0 to 15
+		 * @returns The index of the cell in the chunk
+		 */
+		size_t _localIndex(size_t x, size_t y, size_t z) const
+		{
+			if (this->_layout == Layout::MORTON)
+				return _spread(x) | (_spread(y) << 1) | (_spread(z) << 2);
+			return (z << (2 * CHUNK_BITS)) | (y << CHUNK_BITS) | x;
+		}
+
+		/**
+		 * @brief Get a chunk that only this map has, for changing
+		 * @param chunk	The index of the chunk
+		 * @returns The chunk, copied or made first if need be
+		 */
+		Chunk * _writable(size_t chunk);
+
+		/**
+		 * @brief Make a copy of a component to keep in this map
+		 * @param comp	The component to copy
+		 * @returns The copy, made in the arena if it can be
+		 */
+		Component * _cloneHere(const Component * comp);
+
+		/**
+		 * @brief Make the map bigger so it takes in a location
+		 * @param coords	The coordinates to take in
+		 */
+		void _grow(const Coordinates & coords);
+
+		/**
+		 * @brief Make the map bigger so it takes in a box
+		 * @param box	The box to take in, which isn't empty
+		 */
+		void _growTo(const Box & box);
+
+		/**
+		 * @brief Get the part of a box that is inside the map
+		 * @param box	The box to cut down
+		 * @returns The part inside, which may be empty
+		 */
+		Box _clip(const Box & box) const;
+
+		/**
+		 * @brief Check whether the part of a chunk inside the map is in a box
+		 * @param corner	The lowest corner of the chunk
+		 * @param box	The box to check against
+		 * @returns true if everything the chunk can hold is in the box
+		 */
+		bool _chunkWithin(const Coordinates & corner, const Box & box) const;
+
+		/**
+		 * @brief Visit every location in a box, a chunk at a time
+		 * @warning Assumes the box is inside the map
+		 * @param box	The box to go through
+		 * @param create	Whether to make chunks that are empty, or skip them
+		 * @param visit	Called with the chunk, the cell and the coordinates
+		 * @tparam Visit	void(Chunk &, Component *&, const Coordinates &)
+		 */
+		template<typename Visit>
+		void _forBox(const Box & box, bool create, Visit visit);
+
+		/**
+		 * @brief Stretch a range of chunks to take in some more
+		 *
+		 * It stretches to at least double, so growing a bit at a time doesn't
+		 * lay out the chunks over and over.
+		 *
+		 * @param lo	The first chunk needed
+		 * @param hi	The last chunk needed
+		 * @param first	The first chunk in the range, updated
+		 * @param count	The number of chunks in the range, updated
+		 */
+		static void _stretchRange(int lo, int hi, int & first, size_t & count);
+
+		/**
+		 * @brief Lay out the chunks again over a new range of chunks
+		 * @warning The new range must take in all the chunks in the old one
+		 * @param chunkOrigin	The lowest chunk, in chunks
+		 * @param chunkCount	The number of chunks along each side
+		 */
+		void _layOut(const Coordinates & chunkOrigin, const Size & chunkCount);
 
 
 	private:
 
 		/* Data */
-		Component ** _map = nullptr;
+		Layout _layout;
+		Coordinates _origin;
 		Size _size;
+		Coordinates _chunkOrigin;		// Lowest chunk, in chunks
+		Size _chunkCount;			// Chunks along each side
+		std::vector<std::shared_ptr<Chunk>> _chunks;	// nullptr while empty
+		std::shared_ptr<Arena> _arena;		// Memory for components made here
+
+	};
+
+
+	/**
+	* @brief Quick access to a location and the ones around it
+	*
+	* The chunk of the location is looked up once.  Neighbours in that same
+	* chunk are then read straight from it, without the bounds checks and
+	* chunk lookup that Map::get does.
+	*
+	* @warning Setting anything in the map may leave a cursor looking at old
+	*	memory.  Make a new one after.
+	*/
+	class Map::Cursor
+	{
+
+	public:
+
+		/* Functions */
+
+		/**
+		 * @brief Constructor
+		 * @note Like Map::get, this copies the chunk if another map shares it
+		 * @param map	The map to look in
+		 * @param coords	The location at the center
+		 */
+		Cursor(Map & map, const Coordinates & coords);
+
+		/**
+		 * @brief Get the location at the center
+		 * @returns The coordinates of the location
+		 */
+		const Coordinates & coords() const
+		{
+			return this->_coords;
+		}
+
+		/**
+		 * @brief Get the component at the center
+		 * @returns A pointer to the component there, or nullptr
+		 */
+		Component * get() const
+		{
+			return this->at(0, 0, 0);
+		}
+
+		/**
+		 * @brief Get a component next to the center, or diagonal to it
+		 * @param dx	The offset along x, from -1 to 1
+		 * @param dy	The offset along y, from -1 to 1
+		 * @param dz	The offset along z, from -1 to 1
+		 * @returns A pointer to the component there, or nullptr
+		 */
+		Component * at(int dx, int dy, int dz) const
+		{
+			int x = this->_local.x + dx;
+			int y = this->_local.y + dy;
+			int z = this->_local.z + dz;
+			if (((x | y | z) & ~(CHUNK_SIZE - 1)) != 0)
+				return this->_map->get(Coordinates(
+					this->_coords.x + dx, this->_coords.y + dy, this->_coords.z + dz));
+
+			if (this->_chunk == nullptr)
+				return nullptr;
+			return this->_chunk->cells[this->_map->_localIndex(x, y, z)];
+		}
+
+
+	private:
+
+		/* Data */
+
+		Map * _map;
+		Coordinates _coords;
+		Coordinates _local;		// Inside the chunk, or out of range to always use get
+		Chunk * _chunk;			// nullptr if the chunk is empty
 
 	};
 
@@ -0,0 +1,169 @@
+/**
+* @author Nathan Belue
+* @date October 30, 2015
+*
+* Source code for the packed map class
+*
+*/
+
+#include "PackedMap.h"
+
+#include "_bits/ComponentRegistry.h"
+
+
+const uint8_t Redstone::PackedMap::EMPTY;
+
+
+/**
+ * @brief Constructor
+ * @param size	The size of the map, which starts out empty
+ */
+Redstone::PackedMap::PackedMap(
+	const Redstone::Map::Size & size) :
+	_size(size),
+	_types(size.x * size.y * size.z, EMPTY),
+	_states(size.x * size.y * size.z, 0)
+{}
+
+
+/**
+ * @brief Pack a map
+ * @param map	The map to pack
+ */
+Redstone::PackedMap::PackedMap(
+	const Redstone::Map & map) :
+	PackedMap(map.size())
+{
+	this->_origin = map.origin();
+	map.forEach([this, &map](const Map::Coordinates & coords, const Component * comp) {
+		size_t i = map.index(coords);
+		this->_types[i] = static_cast<uint8_t>(comp->getId());
+		this->_states[i] = static_cast<uint16_t>(comp->getStateKey());
+	});
+}
+
+
+/**
+ * @brief Check whether there is a component at a location
+ * @param coords	The coordinates to look at
+ * @returns true if there is one
+ */
+bool Redstone::PackedMap::has(
+	const Redstone::Map::Coordinates & coords) const
+{
+	size_t index = this->_index(coords);
+	return index != this->volume() && this->_types[index] != EMPTY;
+}
+
+
+/**
+ * @brief Get the ID of the component at a location
+ * @param coords	The coordinates to look at
+ * @returns The ID of the component there
+ */
+Redstone::Component::ID Redstone::PackedMap::getId(
+	const Redstone::Map::Coordinates & coords) const
+{
+	return static_cast<Component::ID>(this->_types[this->_index(coords)]);
+}
+
+
+/**
+ * @brief Get the state key of the component at a location
+ * @param coords	The coordinates to look at
+ * @returns The state key, or 0 if there's nothing there
+ */
+unsigned Redstone::PackedMap::getStateKey(
+	const Redstone::Map::Coordinates & coords) const
+{
+	size_t index = this->_index(coords);
+	if (index == this->volume())
+		return 0;
+	return this->_states[index];
+}
+
+
+/**
+ * @brief Set the component at a location
+ * @param coords	The coordinates for it to be at
+ * @param component	The component to copy, or nullptr for nothing
+ */
+void Redstone::PackedMap::set(
+	const Redstone::Map::Coordinates & coords,
+	const Redstone::Component * component)
+{
+	size_t index = this->_index(coords);
+	if (index == this->volume())
+		return;
+
+	if (component) {
+		this->_types[index] = static_cast<uint8_t>(component->getId());
+		this->_states[index] = static_cast<uint16_t>(component->getStateKey());
+	}
+	else {
+		this->_types[index] = EMPTY;
+		this->_states[index] = 0;
+	}
+}
+
+
+/**
+ * @brief Unpack into a map
+ * @returns A map with a new component for each voxel
+ */
+Redstone::Map Redstone::PackedMap::toMap() const
+{
+	Map map(this->_origin, this->_size);
+
+	for (size_t i = 0; i != this->volume(); ++i) {
+		if (this->_types[i] == EMPTY)
+			continue;
+
+		Component * comp = _create(map, static_cast<Component::ID>(this->_types[i]));
+		if (comp == nullptr)
+			continue;
+
+		comp->setStateKey(this->_states[i]);
+		map.set(map.coordinates(i), comp);
+	}
+
+	return map;
+}
+
+
+/* Helper functions */
+
+
+/**
+ * @brief Get the linear index of a location
+ * @param coords	The coordinates to convert
+ * @returns The index, or volume() if it's outside the map
+ */
+size_t Redstone::PackedMap::_index(
+	const Redstone::Map::Coordinates & coords) const
+{
+	int x = coords.x - this->_origin.x;
+	int y = coords.y - this->_origin.y;
+	int z = coords.z - this->_origin.z;
+	if (x < 0 || y < 0 || z < 0
+			|| x >= static_cast<int>(this->_size.x)
+			|| y >= static_cast<int>(this->_size.y)
+			|| z >= static_cast<int>(this->_size.z))
+		return this->volume();
+
+	return (z * this->_size.y + y) * this->_size.x + x;
+}
+
+
+/**
+ * @brief Make a new component of some type
+ * @param map	The map to make it in
+ * @param id	The ID of the component
+ * @returns The new component, or nullptr if it isn't supported
+ */
+Redstone::Component * Redstone::PackedMap::_create(
+	Redstone::Map & map,
+	Redstone::Component::ID id)
+{
+	return ComponentRegistry::fromId(id).make(map);
+}
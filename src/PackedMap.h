@@ -0,0 +1,161 @@
+/** @file
+* @author Nathan Belue
+* @date October 30, 2015
+*
+* This file contains the packed map class.  It holds the same thing as a
+* Map, but as a flat array of component IDs and a flat array of their
+* states instead of an object for every voxel.  Big maps take a lot less
+* memory this way.
+*
+*/
+
+#ifndef REDSTONE_PACKEDMAP_H
+#define REDSTONE_PACKEDMAP_H
+
+#include <cstdint>
+#include <vector>
+
+#include "Component.h"
+#include "Map.h"
+
+
+/* Redstone namespace */
+namespace Redstone
+{
+
+
+	/**
+	* @brief Packed map class
+	*
+	* Each voxel is a byte for its Component::ID and two bytes for its state
+	* key (see Component::getStateKey).  It is laid out the same as a Map,
+	* so the indices from Map::index work here too.
+	*
+	* To run it, turn it back into a Map with toMap(), or give it straight
+	* to Engine::setMap.
+	*
+	*/
+	class PackedMap
+	{
+
+	public:
+
+		/* Functions */
+
+		/**
+		 * @brief Constructor
+		 * @param size	The size of the map, which starts out empty
+		 */
+		PackedMap(const Map::Size & size = Map::Size());
+
+		/**
+		 * @brief Pack a map
+		 * @param map	The map to pack
+		 */
+		explicit PackedMap(const Map & map);
+
+		/**
+		 * @brief Get the lowest corner of the map
+		 * @returns The coordinates of the corner
+		 */
+		const Map::Coordinates & origin() const
+		{
+			return this->_origin;
+		}
+
+		/**
+		 * @brief Get the size of the map
+		 * @returns The size of the map
+		 */
+		const Map::Size & size() const
+		{
+			return this->_size;
+		}
+
+		/**
+		 * @brief Get the number of voxels in the map
+		 * @returns The width times the height times the depth
+		 */
+		size_t volume() const
+		{
+			return this->_types.size();
+		}
+
+		/**
+		 * @brief Check whether there is a component at a location
+		 * @param coords	The coordinates to look at
+		 * @returns true if there is one
+		 */
+		bool has(const Map::Coordinates & coords) const;
+
+		/**
+		 * @brief Get the ID of the component at a location
+		 * @warning Assumes has(coords)
+		 * @param coords	The coordinates to look at
+		 * @returns The ID of the component there
+		 */
+		Component::ID getId(const Map::Coordinates & coords) const;
+
+		/**
+		 * @brief Get the state key of the component at a location
+		 * @param coords	The coordinates to look at
+		 * @returns The state key, or 0 if there's nothing there
+		 */
+		unsigned getStateKey(const Map::Coordinates & coords) const;
+
+		/**
+		 * @brief Set the component at a location
+		 * @note The component is only read, not kept
+		 * @param coords	The coordinates for it to be at
+		 * @param component	The component to copy, or nullptr for nothing
+		 */
+		void set(const Map::Coordinates & coords, const Component * component);
+
+		/**
+		 * @brief Unpack into a map
+		 * @returns A map with a new component for each voxel
+		 */
+		Map toMap() const;
+
+
+	private:
+
+		/* Helper functions */
+
+		/**
+		 * @brief Get the linear index of a location
+		 * @param coords	The coordinates to convert
+		 * @returns The index, or volume() if it's outside the map
+		 */
+		size_t _index(const Map::Coordinates & coords) const;
+
+		/**
+		 * @brief Make a new component of some type
+		 * @param map	The map to make it in
+		 * @param id	The ID of the component
+		 * @returns The new component, or nullptr if it isn't supported
+		 */
+		static Component * _create(Map & map, Component::ID id);
+
+
+	private:
+
+		/* Constants */
+
+		static const uint8_t EMPTY = 0xFF;	// No component at all
+
+
+		/* Data */
+
+		Map::Coordinates _origin;
+		Map::Size _size;
+		std::vector<uint8_t> _types;		// Component::ID, or EMPTY
+		std::vector<uint16_t> _states;		// State keys
+
+	};
+
+
+} // End of namespace
+
+
+#endif
@@ -16,14 +16,8 @@
 #include <stdexcept>
 #include <vector>
 
+#include "_bits/ComponentRegistry.h"
 #include "_bits/NBTTag.h"
-#include "components/Air.h"
-#include "components/GlassBlock.h"
-#include "components/RedstoneBlock.h"
-#include "components/RedstoneDust.h"
-#include "components/RedstoneTorch.h"
-#include "components/SolidBlock.h"
-#include "components/Switch.h"
 
 
 /**
@@ -148,94 +142,19 @@ void Redstone::Schematic::_readBlocks(
 	auto i = blocks->cbegin();
 	Map::Coordinates coords;
 	Map::Size size = this->_map.size();
-	for (coords.y = 0; coords.y != size.y; ++coords.y) {
-		for (coords.z = 0; coords.z != size.z; ++coords.z) {
-			for (coords.x = 0; coords.x != size.x; ++coords.x, ++i) {
+	const int width = static_cast<int>(size.x);
+	const int height = static_cast<int>(size.y);
+	const int depth = static_cast<int>(size.z);
+	for (coords.y = 0; coords.y != height; ++coords.y) {
+		for (coords.z = 0; coords.z != depth; ++coords.z) {
+			for (coords.x = 0; coords.x != width; ++coords.x, ++i) {
 				if (i == blocks->cend())
 					return;
 
-				Component * comp = nullptr;
-
-				switch (*i) {
-
-				// Air:
-				case 0: comp = new Air(); break;
-
-				// Solids:
-				case 1:		// Stone
-				case 2:		// Grass
-				case 3:		// Dirt
-				case 4:		// Cobblestone
-				case 5:		// Planks
-				case 14:	// Gold ore
-				case 15:	// Iron ore
-				case 16:	// Coal ore
-				case 17:	// Log
-				case 21:	// Lapis ore
-				case 22:	// Lapis block
-				case 24:	// Sandstone
-				case 35:	// Wool
-				case 41:	// Gold block
-				case 42:	// Iron block
-				case 43:	// Double stone slab
-				case 45:	// Brick block
-				case 47:	// Bookshelf
-				case 48:	// Mossy cobblestone
-				case 56:	// Diamond ore
-				case 57:	// Diamond block
-				case 58:	// Crafting table
-				case 80:	// Snow
-				case 82:	// Clay
-				case 86:	// Pumpkin
-				case 87:	// Netherrack
-				case 91:	// Lit pumpkin 
-				case 97:	// Monster egg
-				case 98:	// Stone brick
-				case 99:	// Brown mushroom block
-				case 100:	// Red mushroom block
-				case 103:	// Melon block
-				case 110:	// Mycelium
-				case 112:	// Nether brick
-				case 125:	// Double wooden slab
-				case 129:	// Emerald ore
-				case 133:	// Emerald block
-				case 153:	// Quartz ore
-				case 155:	// Quartz block
-				case 159:	// Stained hardened clay
-				case 162:	// Log 2
-				case 168:	// Prismarine
-				case 169:	// Sea lantern
-				case 170:	// Hay block
-				case 172:	// Hardened clay
-				case 173:	// Coal block
-				case 174:	// Packed ice
-				case 179:	// Red sandstone
-				case 181:	// Double stone slab 2
-				case 201:	// Purpur block
-				case 204:	// Purpur double slab
-				case 206:	// End bricks
-					comp = new SolidBlock();
-					break;
-
-				// Redstone block
-				case 152: comp = new RedstoneBlock(); break;
-					
-				// Glass
-				case 20: comp = new GlassBlock(); break;
-
-				// Redstone dust
-				case 55: comp = new RedstoneDust(); break;
-
-				// Redstone torch (off)
-				case 75: comp = new RedstoneTorch(false); break;
-
-				// Redstone torch (on)
-				case 76: comp = new RedstoneTorch(); break;
-
-				// Lever
-				case 69: comp = new Switch(); break;
-
-				}
+				// Unsupported blocks, and air, make nothing, so chunks of
+				// nothing but air are never allocated
+				Component * comp = ComponentRegistry::fromBlock(
+					static_cast<uint8_t>(*i)).make(this->_map);
 
 				// Set the map!
 				this->_map.set(coords, comp);
@@ -257,80 +176,17 @@ void Redstone::Schematic::_readData(
 	auto i = data->cbegin();
 	Map::Coordinates coords;
 	Map::Size size = this->_map.size();
-	for (coords.y = 0; coords.y != size.y; ++coords.y) {
-		for (coords.z = 0; coords.z != size.z; ++coords.z) {
-			for (coords.x = 0; coords.x != size.x; ++coords.x, ++i) {
+	const int width = static_cast<int>(size.x);
+	const int height = static_cast<int>(size.y);
+	const int depth = static_cast<int>(size.z);
+	for (coords.y = 0; coords.y != height; ++coords.y) {
+		for (coords.z = 0; coords.z != depth; ++coords.z) {
+			for (coords.x = 0; coords.x != width; ++coords.x, ++i) {
 				auto comp = this->_map.get(coords);
 				if (comp == nullptr)
 					continue;
 
-				switch (comp->getId())
-				{
-
-				case Component::ID::REDSTONE_DUST:
-					{
-						auto dust = dynamic_cast<RedstoneDust *>(comp);
-						dust->setLevel(*i);
-					}
-					break;
-
-				case Component::ID::REDSTONE_TORCH:
-					{
-						auto torch = dynamic_cast<RedstoneTorch *>(comp);
-						switch (*i) {
-						case 5:
-							torch->setDirection(Map::Direction::DOWN);
-							break;
-						case 0:
-							torch->setDirection(Map::Direction::NORTH);
-							break;
-						case 4:
-							torch->setDirection(Map::Direction::SOUTH);
-							break;
-						case 1:
-							torch->setDirection(Map::Direction::WEST);
-							break;
-						case 2:
-							torch->setDirection(Map::Direction::EAST);
-							break;
-						default:
-							torch->setDirection(Map::Direction::DOWN);
-							break;
-						}
-					}
-					break;
-
-				case Component::ID::SWITCH:
-					{
-						auto toggle = dynamic_cast<Switch *>(comp);
-						if (*i & 8)
-							toggle->flip();
-
-						switch (*i & 7) {
-						case 5: case 6:
-							toggle->setDirection(Map::Direction::UP);
-							break;
-						case 0: case 7:
-							toggle->setDirection(Map::Direction::DOWN);
-							break;
-						case 4:
-							toggle->setDirection(Map::Direction::SOUTH);
-							break;
-						case 3:
-							toggle->setDirection(Map::Direction::NORTH);
-							break;
-						case 2:
-							toggle->setDirection(Map::Direction::WEST);
-							break;
-						case 1:
-							toggle->setDirection(Map::Direction::EAST);
-							break;
-						}
-					}
-					break;
-
-				}
-
+				ComponentRegistry::fromId(comp->getId()).read(*comp, static_cast<uint8_t>(*i));
 			}
 		}
 	}
@@ -343,61 +199,28 @@ void Redstone::Schematic::_readData(
  */
 std::vector<__int8> Redstone::Schematic::_writeBlocks() const
 {
+	Map::Coordinates origin = this->_map.origin();
 	Map::Size size = this->_map.size();
+	const int width = static_cast<int>(size.x);
+	const int height = static_cast<int>(size.y);
+	const int depth = static_cast<int>(size.z);
 	std::vector<__int8> blocks;
 	blocks.reserve(size.x * size.y * size.z);
 
 	// Read in the block IDs
 	Map::Coordinates coords;
-	for (coords.y = 0; coords.y != size.y; ++coords.y) {
-		for (coords.z = 0; coords.z != size.z; ++coords.z) {
-			for (coords.x = 0; coords.x != size.x; ++coords.x) {
-				auto comp = this->_map.get(coords);
+	for (coords.y = 0; coords.y != height; ++coords.y) {
+		for (coords.z = 0; coords.z != depth; ++coords.z) {
+			for (coords.x = 0; coords.x != width; ++coords.x) {
+				auto comp = this->_map.get(Map::Coordinates(
+					coords.x + origin.x, coords.y + origin.y, coords.z + origin.z));
 				if (comp == nullptr) {
 					blocks.push_back(0);
 					continue;
 				}
 
-				switch (comp->getId())
-				{
-
-				case Component::ID::AIR:
-					blocks.push_back(0);
-					break;
-
-				case Component::ID::GLASS_BLOCK:
-					blocks.push_back(20);
-					break;
-
-				case Component::ID::REDSTONE_BLOCK:
-					blocks.push_back(152u);
-					break;
-
-				case Component::ID::REDSTONE_DUST:
-					blocks.push_back(55);
-					break;
-
-				case Component::ID::REDSTONE_TORCH:
-					{
-						auto torch = dynamic_cast<const RedstoneTorch *>(comp);
-						blocks.push_back(torch->isOn() ? 76 : 75);
-					}
-					break;
-
-				case Component::ID::SOLID_BLOCK:
-					blocks.push_back(35);
-					break;
-
-				case Component::ID::SWITCH:
-					blocks.push_back(69);
-					break;
-
-				default:
-					blocks.push_back(0);
-					break;
-
-				}
-
+				const ComponentRegistry::Type & type = ComponentRegistry::fromId(comp->getId());
+				blocks.push_back(static_cast<__int8>(type.block(*comp)));
 			}
 		}
 	}
@@ -412,84 +235,28 @@ std::vector<__int8> Redstone::Schematic::_writeBlocks() const
  */
 std::vector<__int8> Redstone::Schematic::_writeData() const
 {
+	Map::Coordinates origin = this->_map.origin();
 	Map::Size size = this->_map.size();
+	const int width = static_cast<int>(size.x);
+	const int height = static_cast<int>(size.y);
+	const int depth = static_cast<int>(size.z);
 	std::vector<__int8> data;
 	data.reserve(size.x * size.y * size.z);
 
 	// Read in the block IDs
 	Map::Coordinates coords;
-	for (coords.y = 0; coords.y != size.y; ++coords.y) {
-		for (coords.z = 0; coords.z != size.z; ++coords.z) {
-			for (coords.x = 0; coords.x != size.x; ++coords.x) {
-				auto comp = this->_map.get(coords);
+	for (coords.y = 0; coords.y != height; ++coords.y) {
+		for (coords.z = 0; coords.z != depth; ++coords.z) {
+			for (coords.x = 0; coords.x != width; ++coords.x) {
+				auto comp = this->_map.get(Map::Coordinates(
+					coords.x + origin.x, coords.y + origin.y, coords.z + origin.z));
 				if (comp == nullptr) {
 					data.push_back(0);
 					continue;
 				}
 
-				switch (comp->getId())
-				{
-
-				case Component::ID::REDSTONE_DUST:
-					{
-						auto dust = dynamic_cast<const RedstoneDust *>(comp);
-						data.push_back(dust->getLevel());
-					}
-					break;
-
-				case Component::ID::REDSTONE_TORCH:
-					{
-						auto torch = dynamic_cast<const RedstoneTorch *>(comp);
-						switch (torch->getDirection()) {
-						case Map::Direction::DOWN:
-							data.push_back(5);
-							break;
-						case Map::Direction::NORTH:
-							data.push_back(3);
-							break;
-						case Map::Direction::SOUTH:
-							data.push_back(4);
-							break;
-						case Map::Direction::WEST:
-							data.push_back(1);
-							break;
-						case Map::Direction::EAST:
-							data.push_back(2);
-							break;
-						default:
-							data.push_back(5);
-							break;
-						}
-					}
-					break;
-
-				case Component::ID::SOLID_BLOCK:
-					data.push_back(11);
-					break;
-
-				case Component::ID::SWITCH:
-					{
-						__int8 val = 0;
-						auto toggle = dynamic_cast<const Switch *>(comp);
-						switch (toggle->getDirection()) {
-						case Map::Direction::UP: val = 5; break;
-						case Map::Direction::DOWN: val = 0; break;
-						case Map::Direction::SOUTH: val = 4; break;
-						case Map::Direction::NORTH: val = 3; break;
-						case Map::Direction::WEST: val = 2; break;
-						case Map::Direction::EAST: val = 1; break;
-						}
-						val |= toggle->isOn() ? 8 : 0;
-						data.push_back(val);
-					}
-					break;
-
-				default:
-					data.push_back(0);
-					break;
-
-				}
-
+				const ComponentRegistry::Type & type = ComponentRegistry::fromId(comp->getId());
+				data.push_back(static_cast<__int8>(type.data(*comp)));
 			}
 		}
 	}
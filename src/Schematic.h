@@ -12,6 +12,7 @@
 #define REDSTONE_SCHEMATIC_H
 
 #include "Map.h"
+#include <utility>
 #include <vector>
 #include <gzstream.h>
 
@@ -38,6 +39,15 @@ namespace Redstone
 			this->_map = map;
 		}
 
+		/**
+		 * @brief Set the map we use, without copying it
+		 * @param map	The map the schematic will contain
+		 */
+		void setMap(Map && map)
+		{
+			this->_map = std::move(map);
+		}
+
 		/**
 		 * @brief Get the map we use
 		 * @returns The map the schematic contains
@@ -47,6 +57,15 @@ namespace Redstone
 			return this->_map;
 		}
 
+		/**
+		 * @brief Take the map out of the schematic, without copying it
+		 * @returns The map the schematic contained, leaving it an empty one
+		 */
+		Map takeMap()
+		{
+			return std::move(this->_map);
+		}
+
 		/**
 		 * @brief Save the map to a schematic
 		 * @param outFile	The name of the output file
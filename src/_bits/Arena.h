@@ -0,0 +1,164 @@
+/** @file
+* @author Nathan Belue
+* @date October 31, 2015
+*
+* A map can hold millions of components.  Giving each one its own trip to
+* the heap makes loading, copying and freeing maps crawl, so maps put
+* their components in one of these instead.
+*
+*/
+
+#ifndef REDSTONE_BITS_ARENA_H
+#define REDSTONE_BITS_ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+
+/* Redstone namespace */
+namespace Redstone
+{
+
+
+	/**
+	 * @brief Bump-pointer memory arena
+	 *
+	 * Memory is handed out from big blocks, one after the other, and only
+	 * given back all at once.  Each new block is at least as big as all the
+	 * ones before it, so there are only ever a few of them.
+	 *
+	 * @warning Nothing is destroyed when the memory is given back.  Call the
+	 *	destructors first.
+	 */
+	class Arena
+	{
+
+	public:
+
+		/* Functions */
+
+		Arena() = default;
+		Arena(const Arena &) = delete;
+		Arena & operator =(const Arena &) = delete;
+
+		/**
+		 * @brief Give back all the memory
+		 */
+		~Arena()
+		{
+			this->clear();
+		}
+
+		/**
+		 * @brief Get the bytes an allocation really takes up
+		 * @param bytes	The number of bytes asked for
+		 * @returns The number rounded up to the alignment
+		 */
+		static size_t roundUp(size_t bytes)
+		{
+			return (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+		}
+
+		/**
+		 * @brief Get some memory
+		 * @param bytes	The number of bytes needed
+		 * @returns The memory, aligned for any type
+		 */
+		void * allocate(size_t bytes)
+		{
+			bytes = roundUp(bytes);
+			this->reserve(bytes);
+
+			Block & block = this->_blocks.back();
+			void * memory = block.data + this->_used;
+			this->_used += bytes;
+			return memory;
+		}
+
+		/**
+		 * @brief Make sure some bytes fit without another block after this
+		 * @param bytes	The number of bytes that will be needed
+		 */
+		void reserve(size_t bytes)
+		{
+			if (!this->_blocks.empty() && this->_used + bytes <= this->_blocks.back().size)
+				return;
+
+			size_t size = this->_capacity;
+			if (size < MIN_BLOCK)
+				size = MIN_BLOCK;
+			if (size < bytes)
+				size = bytes;
+
+			this->_blocks.push_back(Block{ new char[size], size });
+			this->_capacity += size;
+			this->_used = 0;
+		}
+
+		/**
+		 * @brief Check whether some memory came from this arena
+		 * @param memory	The memory to look for
+		 * @returns true if it is inside one of the blocks
+		 */
+		bool contains(const void * memory) const
+		{
+			auto p = static_cast<const char *>(memory);
+			for (auto b = this->_blocks.crbegin(); b != this->_blocks.crend(); ++b) {
+				if (p >= b->data && p < b->data + b->size)
+					return true;
+			}
+			return false;
+		}
+
+		/**
+		 * @brief Get the number of bytes held from the heap
+		 * @returns The size of all the blocks
+		 */
+		size_t capacity() const
+		{
+			return this->_capacity;
+		}
+
+		/**
+		 * @brief Give back all the memory
+		 */
+		void clear()
+		{
+			for (auto & block : this->_blocks)
+				delete[] block.data;
+			this->_blocks.clear();
+			this->_capacity = 0;
+			this->_used = 0;
+		}
+
+
+	private:
+
+		/* Types */
+
+		struct Block
+		{
+			char * data;
+			size_t size;
+		};
+
+
+		/* Constants */
+
+		static const size_t ALIGNMENT = alignof(std::max_align_t);
+		static const size_t MIN_BLOCK = 4096;
+
+
+		/* Data */
+
+		std::vector<Block> _blocks;
+		size_t _capacity = 0;		// Bytes in all the blocks
+		size_t _used = 0;			// Bytes used in the last block
+
+	};
+
+
+}
+
+
+#endif
@@ -0,0 +1,386 @@
+/** @file
+* @author Nathan Belue
+* @date November 5, 2015
+*
+* Schematics and packed maps both have to turn a number into a component,
+* and schematics have to turn components back into numbers.  Each of those
+* used to be its own switch, so a new component meant finding and changing
+* all of them.  This puts them in two tables made at compile time: one by
+* schematic block ID, and one by Component::ID.
+*
+*/
+
+#ifndef REDSTONE_BITS_COMPONENTREGISTRY_H
+#define REDSTONE_BITS_COMPONENTREGISTRY_H
+
+#include <cstdint>
+
+#include "../Component.h"
+#include "../Map.h"
+#include "../components/Air.h"
+#include "../components/GlassBlock.h"
+#include "../components/RedstoneBlock.h"
+#include "../components/RedstoneDust.h"
+#include "../components/RedstoneTorch.h"
+#include "../components/SolidBlock.h"
+#include "../components/Switch.h"
+
+
+/* Redstone namespace */
+namespace Redstone
+{
+
+
+	/**
+	 * @brief Tables of how to make, save, and load each component
+	 *
+	 * Looking something up is a single index into an array, with no
+	 * branches.  Numbers that mean nothing get entries that do nothing,
+	 * like making nullptr or writing 0.
+	 */
+	class ComponentRegistry
+	{
+
+	public:
+
+		/* Types */
+
+		/**
+		 * @brief Make a component in a map
+		 * @param map	The map it will be put in
+		 * @returns The component, or nullptr to leave the location empty
+		 */
+		typedef Component * (*Factory)(Map & map);
+
+		/**
+		 * @brief Turn a component into a byte of a schematic
+		 * @param comp	The component
+		 * @returns The byte
+		 */
+		typedef uint8_t (*Writer)(const Component & comp);
+
+		/**
+		 * @brief Set up a component from a byte of a schematic
+		 * @param comp	The component
+		 * @param data	The byte
+		 */
+		typedef void (*Reader)(Component & comp, uint8_t data);
+
+		/**
+		 * @brief What a schematic block ID loads as
+		 */
+		struct Block
+		{
+			Component::ID id;	/** the component it turns into, AIR if none */
+			Factory make;		/** makes it, before its data is read */
+		};
+
+		/**
+		 * @brief How to make, save, and load a Component::ID
+		 */
+		struct Type
+		{
+			Factory make;	/** makes one in its default state, or nullptr */
+			Writer block;	/** its schematic block ID */
+			Writer data;	/** its schematic block data */
+			Reader read;	/** sets it up from its schematic block data */
+		};
+
+
+		/* Functions */
+
+		/**
+		 * @brief Look up a schematic block ID
+		 * @param block	The block ID
+		 * @returns What it loads as
+		 */
+		static const Block & fromBlock(uint8_t block);
+
+		/**
+		 * @brief Look up a Component::ID
+		 * @param id	The ID
+		 * @returns How to handle it, which does nothing if it isn't known
+		 */
+		static const Type & fromId(Component::ID id);
+
+
+	private:
+
+		/* Types */
+
+		struct Blocks
+		{
+			Block entries[256];
+		};
+
+		struct Types
+		{
+			Type entries[Map::ID_SLOTS + 1];	// The last is for unknown IDs
+		};
+
+
+		/* Helper functions */
+
+		/**
+		 * @brief Fill in the table of block IDs
+		 * @returns The table
+		 */
+		static constexpr Blocks _blocks()
+		{
+			// Everything else is a solid of some sort
+			const uint8_t solids[] = {
+				1,		// Stone
+				2,		// Grass
+				3,		// Dirt
+				4,		// Cobblestone
+				5,		// Planks
+				14,		// Gold ore
+				15,		// Iron ore
+				16,		// Coal ore
+				17,		// Log
+				21,		// Lapis ore
+				22,		// Lapis block
+				24,		// Sandstone
+				35,		// Wool
+				41,		// Gold block
+				42,		// Iron block
+				43,		// Double stone slab
+				45,		// Brick block
+				47,		// Bookshelf
+				48,		// Mossy cobblestone
+				56,		// Diamond ore
+				57,		// Diamond block
+				58,		// Crafting table
+				80,		// Snow
+				82,		// Clay
+				86,		// Pumpkin
+				87,		// Netherrack
+				91,		// Lit pumpkin
+				97,		// Monster egg
+				98,		// Stone brick
+				99,		// Brown mushroom block
+				100,	// Red mushroom block
+				103,	// Melon block
+				110,	// Mycelium
+				112,	// Nether brick
+				125,	// Double wooden slab
+				129,	// Emerald ore
+				133,	// Emerald block
+				153,	// Quartz ore
+				155,	// Quartz block
+				159,	// Stained hardened clay
+				162,	// Log 2
+				168,	// Prismarine
+				169,	// Sea lantern
+				170,	// Hay block
+				172,	// Hardened clay
+				173,	// Coal block
+				174,	// Packed ice
+				179,	// Red sandstone
+				181,	// Double stone slab 2
+				201,	// Purpur block
+				204,	// Purpur double slab
+				206		// End bricks
+			};
+
+			// Air, and anything not supported, is left empty, so chunks of
+			// nothing but air are never allocated
+			Blocks table = {};
+			for (auto & entry : table.entries) {
+				entry.id = Component::ID::AIR;
+				entry.make = &_none;
+			}
+
+			for (auto block : solids)
+				table.entries[block] = Block{ Component::ID::SOLID_BLOCK, &_make<SolidBlock> };
+
+			table.entries[20] = Block{ Component::ID::GLASS_BLOCK, &_shared<GlassBlock> };
+			table.entries[55] = Block{ Component::ID::REDSTONE_DUST, &_make<RedstoneDust> };
+			table.entries[69] = Block{ Component::ID::SWITCH, &_make<Switch> };	// Lever
+			table.entries[75] = Block{ Component::ID::REDSTONE_TORCH, &_makeTorchOff };
+			table.entries[76] = Block{ Component::ID::REDSTONE_TORCH, &_make<RedstoneTorch> };
+			table.entries[152] = Block{ Component::ID::REDSTONE_BLOCK, &_shared<RedstoneBlock> };
+			return table;
+		}
+
+		/**
+		 * @brief Fill in the table of Component::IDs
+		 * @returns The table
+		 */
+		static constexpr Types _types()
+		{
+			Types table = {};
+			for (auto & entry : table.entries)
+				entry = Type{ &_none, &_byte<0>, &_byte<0>, &_ignore };
+
+			table.entries[_slot(Component::ID::AIR)] =
+				Type{ &_shared<Air>, &_byte<0>, &_byte<0>, &_ignore };
+			table.entries[_slot(Component::ID::GLASS_BLOCK)] =
+				Type{ &_shared<GlassBlock>, &_byte<20>, &_byte<0>, &_ignore };
+			table.entries[_slot(Component::ID::REDSTONE_BLOCK)] =
+				Type{ &_shared<RedstoneBlock>, &_byte<152>, &_byte<0>, &_ignore };
+			table.entries[_slot(Component::ID::REDSTONE_DUST)] =
+				Type{ &_make<RedstoneDust>, &_byte<55>, &_writeDust, &_readDust };
+			table.entries[_slot(Component::ID::REDSTONE_TORCH)] =
+				Type{ &_make<RedstoneTorch>, &_torchBlock, &_writeTorch, &_readTorch };
+			table.entries[_slot(Component::ID::SOLID_BLOCK)] =
+				Type{ &_make<SolidBlock>, &_byte<35>, &_byte<11>, &_ignore };	// Wool
+			table.entries[_slot(Component::ID::SWITCH)] =
+				Type{ &_make<Switch>, &_byte<69>, &_writeSwitch, &_readSwitch };
+			return table;
+		}
+
+		/**
+		 * @brief Get the index of a Component::ID in the table
+		 * @param id	The ID
+		 * @returns The index
+		 */
+		static constexpr int _slot(Component::ID id)
+		{
+			return static_cast<int>(id);
+		}
+
+
+		/* Factories */
+
+		static Component * _none(Map & /*map*/)
+		{
+			return nullptr;
+		}
+
+		template<typename T>
+		static Component * _make(Map & map)
+		{
+			return map.make<T>();
+		}
+
+		template<typename T>
+		static Component * _shared(Map & /*map*/)
+		{
+			return T::shared();
+		}
+
+		static Component * _makeTorchOff(Map & map)
+		{
+			return map.make<RedstoneTorch>(false);
+		}
+
+
+		/* Writers */
+
+		template<uint8_t B>
+		static uint8_t _byte(const Component & /*comp*/)
+		{
+			return B;
+		}
+
+		static uint8_t _torchBlock(const Component & comp)
+		{
+			return componentCast<RedstoneTorch>(comp).isOn() ? 76 : 75;
+		}
+
+		static uint8_t _writeDust(const Component & comp)
+		{
+			return static_cast<uint8_t>(componentCast<RedstoneDust>(comp).getLevel());
+		}
+
+		static uint8_t _writeTorch(const Component & comp)
+		{
+			switch (componentCast<RedstoneTorch>(comp).getDirection()) {
+			case Map::Direction::NORTH: return 3;
+			case Map::Direction::SOUTH: return 4;
+			case Map::Direction::WEST: return 1;
+			case Map::Direction::EAST: return 2;
+			default: return 5;
+			}
+		}
+
+		static uint8_t _writeSwitch(const Component & comp)
+		{
+			const Switch & toggle = componentCast<Switch>(comp);
+			uint8_t val = 0;
+			switch (toggle.getDirection()) {
+			case Map::Direction::UP: val = 5; break;
+			case Map::Direction::DOWN: val = 0; break;
+			case Map::Direction::SOUTH: val = 4; break;
+			case Map::Direction::NORTH: val = 3; break;
+			case Map::Direction::WEST: val = 2; break;
+			case Map::Direction::EAST: val = 1; break;
+			}
+			return val | (toggle.isOn() ? 8 : 0);
+		}
+
+
+		/* Readers */
+
+		static void _ignore(Component & /*comp*/, uint8_t /*data*/)
+		{}
+
+		static void _readDust(Component & comp, uint8_t data)
+		{
+			componentCast<RedstoneDust>(&comp)->setLevel(data);
+		}
+
+		static void _readTorch(Component & comp, uint8_t data)
+		{
+			RedstoneTorch * torch = componentCast<RedstoneTorch>(&comp);
+			switch (data) {
+			case 0: torch->setDirection(Map::Direction::NORTH); break;
+			case 4: torch->setDirection(Map::Direction::SOUTH); break;
+			case 1: torch->setDirection(Map::Direction::WEST); break;
+			case 2: torch->setDirection(Map::Direction::EAST); break;
+			default: torch->setDirection(Map::Direction::DOWN); break;
+			}
+		}
+
+		static void _readSwitch(Component & comp, uint8_t data)
+		{
+			Switch * toggle = componentCast<Switch>(&comp);
+			if (data & 8)
+				toggle->flip();
+
+			switch (data & 7) {
+			case 5: case 6: toggle->setDirection(Map::Direction::UP); break;
+			case 0: case 7: toggle->setDirection(Map::Direction::DOWN); break;
+			case 4: toggle->setDirection(Map::Direction::SOUTH); break;
+			case 3: toggle->setDirection(Map::Direction::NORTH); break;
+			case 2: toggle->setDirection(Map::Direction::WEST); break;
+			case 1: toggle->setDirection(Map::Direction::EAST); break;
+			}
+		}
+
+	};
+
+
+	/* The tables can only be made once the class is complete */
+
+
+	/**
+	 * @brief Look up a schematic block ID
+	 * @param block	The block ID
+	 * @returns What it loads as
+	 */
+	inline const ComponentRegistry::Block & ComponentRegistry::fromBlock(uint8_t block)
+	{
+		static constexpr Blocks table = _blocks();
+		return table.entries[block];
+	}
+
+
+	/**
+	 * @brief Look up a Component::ID
+	 * @param id	The ID
+	 * @returns How to handle it, which does nothing if it isn't known
+	 */
+	inline const ComponentRegistry::Type & ComponentRegistry::fromId(Component::ID id)
+	{
+		static constexpr Types table = _types();
+		unsigned slot = static_cast<unsigned>(id);
+		return table.entries[slot < Map::ID_SLOTS ? slot : Map::ID_SLOTS];
+	}
+
+
+}
+
+
+#endif
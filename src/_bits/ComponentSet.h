@@ -0,0 +1,147 @@
+/** @file
+* @author Nathan Belue
+* @date November 2, 2015
+*
+* Every update goes through a virtual call, and so does every look at a
+* neighbour.  The compiler can't see through those, so nothing about the
+* components gets inlined into the engine's loop.  The set of components
+* is closed though, so this turns a component's ID into a call on its
+* real class with a jump table instead.
+*
+*/
+
+#ifndef REDSTONE_BITS_COMPONENTSET_H
+#define REDSTONE_BITS_COMPONENTSET_H
+
+#include <type_traits>
+#include <utility>
+
+#include "../Component.h"
+#include "../components/Air.h"
+#include "../components/GlassBlock.h"
+#include "../components/RedstoneBlock.h"
+#include "../components/RedstoneDust.h"
+#include "../components/RedstoneTorch.h"
+#include "../components/SolidBlock.h"
+#include "../components/Switch.h"
+
+
+/* Redstone namespace */
+namespace Redstone
+{
+
+
+	/**
+	 * @brief A closed set of component classes
+	 *
+	 * visit() looks the component's ID up in a table made at compile time,
+	 * and calls the visitor with the component as its own class.  Mark the
+	 * classes final, and calls made on them in the visitor are no longer
+	 * virtual.  Components outside of the set are passed on as plain
+	 * Components.
+	 *
+	 * @tparam Ts	The classes in the set, each with a static TYPE
+	 */
+	template<typename... Ts>
+	class ComponentSet
+	{
+
+	public:
+
+		/**
+		 * @brief Call a visitor with a component as its own class
+		 * @param comp	The component
+		 * @param visit	Called with a reference to the component
+		 * @tparam Base	Component, or const Component
+		 * @tparam Visit	Result(T &), for each T and for Component, const
+		 *	if Base is
+		 * @returns What the visitor returns
+		 */
+		template<typename Base, typename Visit>
+		static auto visit(Base & comp, Visit && visit)
+			-> decltype(visit(comp))
+		{
+			static_assert(std::is_same<typename std::remove_const<Base>::type, Component>::value,
+				"ComponentSet::visit takes a Component");
+			return _dispatch<decltype(visit(comp)), Base>(
+				comp, visit, std::make_integer_sequence<int, Map::ID_SLOTS>());
+		}
+
+
+	private:
+
+		/* Types */
+
+		/**
+		 * @brief Find the class in the set with some ID
+		 * @tparam I	The ID, as an int
+		 * @tparam Us	The classes left to look through
+		 */
+		template<int I, typename... Us>
+		struct _Find
+		{
+			typedef Component type;		// Not in the set
+		};
+
+		template<int I, typename U, typename... Us>
+		struct _Find<I, U, Us...>
+		{
+			typedef typename std::conditional<static_cast<int>(U::TYPE) == I,
+				U, typename _Find<I, Us...>::type>::type type;
+		};
+
+
+		/* Helper functions */
+
+		/**
+		 * @brief Call a visitor with a component cast to a class
+		 * @param comp	The component
+		 * @param visit	The visitor
+		 * @tparam T	The class of the component, or Component
+		 * @tparam Result	What the visitor returns
+		 * @tparam Base	Component, or const Component
+		 * @tparam Visit	The type of the visitor
+		 * @returns What the visitor returns
+		 */
+		template<typename T, typename Result, typename Base, typename Visit>
+		static Result _call(Base & comp, Visit & visit)
+		{
+			typedef typename std::conditional<std::is_const<Base>::value,
+				const T, T>::type Target;
+			return visit(static_cast<Target &>(comp));
+		}
+
+		/**
+		 * @brief Look up the entry for a component in the jump table
+		 * @param comp	The component
+		 * @param visit	The visitor
+		 * @tparam Result	What the visitor returns
+		 * @tparam Base	Component, or const Component
+		 * @tparam Visit	The type of the visitor
+		 * @tparam I	Every ID, as an int
+		 * @returns What the visitor returns
+		 */
+		template<typename Result, typename Base, typename Visit, int... I>
+		static Result _dispatch(Base & comp, Visit & visit, std::integer_sequence<int, I...>)
+		{
+			typedef Result (*Entry)(Base &, Visit &);
+			static const Entry table[] = {
+				&_call<typename _Find<I, Ts...>::type, Result, Base, Visit>...
+			};
+			return table[static_cast<int>(comp.getId())](comp, visit);
+		}
+
+	};
+
+
+	/**
+	 * @brief The components the engine knows about
+	 */
+	typedef ComponentSet<Air, GlassBlock, RedstoneBlock, RedstoneDust,
+		RedstoneTorch, SolidBlock, Switch> KnownComponents;
+
+
+}
+
+
+#endif
@@ -0,0 +1,373 @@
+/** @file
+* @author Nathan Belue
+* @date November 4, 2015
+*
+* Working out the levels of a wire of redstone dust means finding all of
+* the dust in it first, by looking at the fourteen locations around each
+* one.  That search costs more than the levels do, and it turns up the same
+* wire every time until something is built or broken near it.  This keeps
+* the wires that have been found, so they can be used again.
+*
+*/
+
+#ifndef REDSTONE_BITS_DUSTGRAPH_H
+#define REDSTONE_BITS_DUSTGRAPH_H
+
+#include <algorithm>
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../Map.h"
+
+
+/* Redstone namespace */
+namespace Redstone
+{
+
+
+	/* Forward declarations */
+	class Component;
+	class RedstoneDust;
+
+
+	/**
+	 * @brief Cache of the wires of redstone dust in a map
+	 *
+	 * Each wire remembers the chunks it looked at while it was found, and
+	 * their stamps (see Map::stamp).  It is only handed out again while
+	 * none of those chunks have changed, so building or breaking something
+	 * throws away the wires next to it and leaves the rest alone.  Changes
+	 * to the state of components, like a switch flipping, don't count.
+	 *
+	 * Everything about a wire is kept in flat arrays, indexed by the
+	 * position of each dust in the wire.
+	 */
+	class DustGraph
+	{
+
+	public:
+
+		/* Constants */
+
+		/**
+		 * @brief Locations looked at around each dust
+		 */
+		static const int AROUND = 14;
+
+
+		/* Types */
+
+		/**
+		 * @brief Every dust connected to each other
+		 */
+		struct Wire
+		{
+			std::vector<Map::Coordinates> coords;	/** of each dust */
+			std::vector<RedstoneDust *> dust;
+			std::vector<Component *> around;	/** AROUND per dust, in the order of offset() */
+			std::vector<int> first;		/** dust n is read by readers[first[n]] to readers[first[n + 1]] */
+			std::vector<int> readers;
+			std::vector<Map::Coordinates> chunks;	/** a location in each chunk looked at */
+			std::vector<unsigned long long> stamps;	/** the stamp of each of those chunks */
+
+			/**
+			 * @brief Get the number of dust in the wire
+			 * @returns The count
+			 */
+			size_t size() const
+			{
+				return this->dust.size();
+			}
+		};
+
+		/**
+		 * @brief Room to work out the levels of a wire in
+		 *
+		 * Only one wire is worked out at a time, so the same vectors are
+		 * used for every one and stop allocating once they are big enough.
+		 */
+		struct Scratch
+		{
+			std::vector<int> oldLevels;		/** of each dust, before */
+			std::vector<int> oldDirections;
+			std::vector<unsigned> oldVisible;	/** from Engine::beginChange */
+			std::vector<unsigned char> levels;	/** of each dust, as it is worked out */
+			std::vector<int> order;		/** dust by starting level, strongest first */
+			std::vector<int> raised;	/** dust raised to the level being spread */
+			std::vector<int> next;		/** dust raised to the level after that */
+		};
+
+
+		/* Functions */
+
+		/**
+		 * @brief Get the offset of a location around a dust
+		 *
+		 * The six faces come first (+x, -x, +z, -z, +y, -y), then the eight
+		 * diagonals in the order of RedstoneDust's diagonal flags.
+		 *
+		 * @param k	Which location, from 0 to AROUND
+		 * @returns The offsets along x, y, and z
+		 */
+		static const int * offset(int k)
+		{
+			static const int offsets[AROUND][3] = {
+				{ 1, 0, 0 }, { -1, 0, 0 }, { 0, 0, 1 }, { 0, 0, -1 }, { 0, 1, 0 }, { 0, -1, 0 },
+				{ 0, 1, 1 }, { 1, 1, 0 }, { 0, 1, -1 }, { -1, 1, 0 },
+				{ 0, -1, 1 }, { 1, -1, 0 }, { 0, -1, -1 }, { -1, -1, 0 }
+			};
+			return offsets[k];
+		}
+
+		/**
+		 * @brief Get a location around a dust
+		 * @param coords	The location of the dust
+		 * @param k	Which location, from 0 to AROUND
+		 * @returns The coordinates of the location
+		 */
+		static Map::Coordinates around(const Map::Coordinates & coords, int k)
+		{
+			const int * o = offset(k);
+			return Map::Coordinates(coords.x + o[0], coords.y + o[1], coords.z + o[2]);
+		}
+
+		/**
+		 * @brief Find the wire a dust is in, if it can still be trusted
+		 *
+		 * A wire that is found to be out of date is thrown away.
+		 *
+		 * @param map	The map the wire is in
+		 * @param coords	The location of the dust
+		 * @returns The wire, or nullptr if it has to be found again
+		 */
+		const Wire * find(const Map & map, const Map::Coordinates & coords)
+		{
+			if (!map.contains(coords))
+				return nullptr;
+
+			auto it = this->_where.find(map.index(coords));
+			if (it == this->_where.end())
+				return nullptr;
+
+			int w = it->second.first;
+			size_t n = it->second.second;
+			const Wire & wire = this->_wires[w];
+			if (n >= wire.size() || !_same(wire.coords[n], coords)) {
+				this->_where.erase(it);
+				return nullptr;
+			}
+
+			for (size_t i = 0; i != wire.chunks.size(); ++i) {
+				if (map.stamp(wire.chunks[i]) != wire.stamps[i]) {
+					this->_erase(map, w);
+					return nullptr;
+				}
+			}
+			return &wire;
+		}
+
+		/**
+		 * @brief Keep a wire that was just found
+		 *
+		 * The stamps of the chunks it looked at are taken now, so they must
+		 * not have changed since it was found.  Any wire that any of its
+		 * dust was in before is thrown away.
+		 *
+		 * @param map	The map the wire is in
+		 * @param wire	The wire, with everything but chunks and stamps
+		 * @returns The wire, until the next call to insert or clear
+		 */
+		const Wire & insert(const Map & map, Wire && wire)
+		{
+			// Each chunk once, lowest corner first
+			wire.chunks.clear();
+			for (size_t n = 0; n != wire.size(); ++n) {
+				wire.chunks.push_back(_chunkOf(wire.coords[n]));
+				for (int k = 0; k != AROUND; ++k)
+					wire.chunks.push_back(_chunkOf(around(wire.coords[n], k)));
+			}
+			std::sort(wire.chunks.begin(), wire.chunks.end(), _less);
+			wire.chunks.erase(std::unique(wire.chunks.begin(), wire.chunks.end(), _same),
+				wire.chunks.end());
+			wire.stamps.resize(wire.chunks.size());
+			for (size_t i = 0; i != wire.chunks.size(); ++i)
+				wire.stamps[i] = map.stamp(wire.chunks[i]);
+
+			// Find a slot for it
+			int w;
+			if (this->_free.empty()) {
+				w = static_cast<int>(this->_wires.size());
+				this->_wires.emplace_back();
+			}
+			else {
+				w = this->_free.back();
+				this->_free.pop_back();
+			}
+
+			for (size_t n = 0; n != wire.size(); ++n) {
+				size_t index = map.index(wire.coords[n]);
+				auto it = this->_where.find(index);
+				if (it != this->_where.end() && it->second.first != w)
+					this->_erase(map, it->second.first);
+				this->_where[index] = std::make_pair(w, static_cast<int>(n));
+			}
+
+			this->_wires[w] = std::move(wire);
+			return this->_wires[w];
+		}
+
+		/**
+		 * @brief Look every wire up again after the map has been resized
+		 *
+		 * Wires are found by map index, and indices change when the map
+		 * grows.  Dust that is no longer in the map can't be found.
+		 *
+		 * @param map	The map the wires are in
+		 */
+		void reindex(const Map & map)
+		{
+			this->_where.clear();
+			for (size_t w = 0; w != this->_wires.size(); ++w) {
+				const Wire & wire = this->_wires[w];
+				for (size_t n = 0; n != wire.size(); ++n) {
+					if (map.contains(wire.coords[n]))
+						this->_where[map.index(wire.coords[n])] =
+							std::make_pair(static_cast<int>(w), static_cast<int>(n));
+				}
+			}
+		}
+
+		/**
+		 * @brief Get the room to work out the levels of a wire in
+		 * @returns The scratch space, with whatever was left in it
+		 */
+		Scratch & scratch()
+		{
+			return this->_scratch;
+		}
+
+		/**
+		 * @brief Forget every wire
+		 */
+		void clear()
+		{
+			this->_wires.clear();
+			this->_free.clear();
+			this->_where.clear();
+		}
+
+		/**
+		 * @brief Get the heap memory the cache holds
+		 * @note The size of the lookup table is a guess at how the standard
+		 *	library lays it out
+		 * @returns The bytes taken by every wire, the lookup table, and the
+		 *	scratch space
+		 */
+		size_t memoryUsage() const
+		{
+			size_t bytes = this->_wires.capacity() * sizeof(Wire)
+				+ this->_free.capacity() * sizeof(int)
+				+ this->_where.bucket_count() * sizeof(void *)
+				+ this->_where.size() * (sizeof(void *) + sizeof(size_t)
+					+ sizeof(std::pair<const size_t, std::pair<int, int>>));
+			bytes += this->_scratch.oldLevels.capacity() * sizeof(int)
+				+ this->_scratch.oldDirections.capacity() * sizeof(int)
+				+ this->_scratch.oldVisible.capacity() * sizeof(unsigned)
+				+ this->_scratch.levels.capacity() * sizeof(unsigned char)
+				+ this->_scratch.order.capacity() * sizeof(int)
+				+ this->_scratch.raised.capacity() * sizeof(int)
+				+ this->_scratch.next.capacity() * sizeof(int);
+			for (auto & wire : this->_wires) {
+				bytes += wire.coords.capacity() * sizeof(Map::Coordinates)
+					+ wire.dust.capacity() * sizeof(RedstoneDust *)
+					+ wire.around.capacity() * sizeof(Component *)
+					+ wire.first.capacity() * sizeof(int)
+					+ wire.readers.capacity() * sizeof(int)
+					+ wire.chunks.capacity() * sizeof(Map::Coordinates)
+					+ wire.stamps.capacity() * sizeof(unsigned long long);
+			}
+			return bytes;
+		}
+
+
+	private:
+
+		/* Helper functions */
+
+		/**
+		 * @brief Check whether two locations are the same
+		 * @param a	One location
+		 * @param b	The other location
+		 * @returns true if they are
+		 */
+		static bool _same(const Map::Coordinates & a, const Map::Coordinates & b)
+		{
+			return a.x == b.x && a.y == b.y && a.z == b.z;
+		}
+
+		/**
+		 * @brief Order locations, z first
+		 * @param a	One location
+		 * @param b	The other location
+		 * @returns true if a comes before b
+		 */
+		static bool _less(const Map::Coordinates & a, const Map::Coordinates & b)
+		{
+			if (a.z != b.z)
+				return a.z < b.z;
+			if (a.y != b.y)
+				return a.y < b.y;
+			return a.x < b.x;
+		}
+
+		/**
+		 * @brief Get the lowest corner of the chunk a location is in
+		 * @param coords	The location
+		 * @returns The coordinates of the corner
+		 */
+		static Map::Coordinates _chunkOf(const Map::Coordinates & coords)
+		{
+			const int mask = ~((1 << Map::CHUNK_BITS) - 1);
+			return Map::Coordinates(coords.x & mask, coords.y & mask, coords.z & mask);
+		}
+
+		/**
+		 * @brief Throw a wire away, and free its slot
+		 * @param map	The map the wire is in
+		 * @param w	The slot of the wire
+		 */
+		void _erase(const Map & map, int w)
+		{
+			Wire & wire = this->_wires[w];
+			if (wire.size() == 0)
+				return;		// Already free
+
+			for (size_t n = 0; n != wire.size(); ++n) {
+				if (!map.contains(wire.coords[n]))
+					continue;
+				auto it = this->_where.find(map.index(wire.coords[n]));
+				if (it != this->_where.end() && it->second == std::make_pair(w, static_cast<int>(n)))
+					this->_where.erase(it);
+			}
+			wire = Wire();
+			this->_free.push_back(w);
+		}
+
+
+	private:
+
+		/* Data */
+
+		std::vector<Wire> _wires;	// Empty in free slots
+		std::vector<int> _free;		// Slots of _wires to use again
+		std::unordered_map<size_t, std::pair<int, int>> _where;	// Map index to slot and position
+		Scratch _scratch;
+	};
+
+
+}
+
+
+#endif
@@ -0,0 +1,137 @@
+/** @file
+* @author Nathan Belue
+* @date October 29, 2015
+*
+* The engine's update queue is pushed and popped many times every tick.
+* std::queue keeps allocating and freeing chunks while it does that, so
+* this is a plain ring buffer that keeps its memory between ticks.
+*
+*/
+
+#ifndef REDSTONE_BITS_RINGBUFFER_H
+#define REDSTONE_BITS_RINGBUFFER_H
+
+#include <cstddef>
+#include <vector>
+
+
+/* Redstone namespace */
+namespace Redstone
+{
+
+
+	/**
+	 * @brief First-in first-out ring buffer
+	 *
+	 * The capacity is always a power of two, and doubles when it fills up.
+	 * It never shrinks, so once it is big enough nothing is allocated.
+	 *
+	 * @tparam T	The type of the items
+	 */
+	template<typename T>
+	class RingBuffer
+	{
+
+	public:
+
+		/**
+		 * @brief Check whether there are any items
+		 * @returns true if there are none
+		 */
+		bool empty() const
+		{
+			return this->_count == 0;
+		}
+
+		/**
+		 * @brief Get the number of items
+		 * @returns The number of items waiting
+		 */
+		size_t size() const
+		{
+			return this->_count;
+		}
+
+		/**
+		 * @brief Get the number of items that fit before it has to grow
+		 * @returns The capacity
+		 */
+		size_t capacity() const
+		{
+			return this->_items.size();
+		}
+
+		/**
+		 * @brief Get the first item
+		 * @warning Assumes it's not empty
+		 * @returns The item that was pushed first
+		 */
+		const T & front() const
+		{
+			return this->_items[this->_head];
+		}
+
+		/**
+		 * @brief Add an item to the back
+		 * @param item	The item to add
+		 */
+		void push(const T & item)
+		{
+			if (this->_count == this->_items.size())
+				this->_grow();
+			this->_items[(this->_head + this->_count) & (this->_items.size() - 1)] = item;
+			++ this->_count;
+		}
+
+		/**
+		 * @brief Take the first item off
+		 * @warning Assumes it's not empty
+		 */
+		void pop()
+		{
+			this->_head = (this->_head + 1) & (this->_items.size() - 1);
+			-- this->_count;
+		}
+
+		/**
+		 * @brief Remove everything, but keep the memory
+		 */
+		void clear()
+		{
+			this->_head = 0;
+			this->_count = 0;
+		}
+
+
+	private:
+
+		/* Helper functions */
+
+		/**
+		 * @brief Double the capacity, and line the items up from the start
+		 */
+		void _grow()
+		{
+			std::vector<T> items(this->_items.empty() ? 64 : this->_items.size() * 2);
+			for (size_t i = 0; i != this->_count; ++i)
+				items[i] = this->_items[(this->_head + i) & (this->_items.size() - 1)];
+			this->_items.swap(items);
+			this->_head = 0;
+		}
+
+
+	private:
+
+		/* Data */
+
+		std::vector<T> _items;
+		size_t _head = 0;
+		size_t _count = 0;
+
+	};
+
+
+}
+
+
+#endif
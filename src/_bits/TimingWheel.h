@@ -0,0 +1,319 @@
+/** @file
+* @author Nathan Belue
+* @date October 28, 2015
+*
+* The engine needs a way to put off updates for a few ticks without looking
+* at them again every tick.  This is a hierarchical timing wheel, which
+* holds items until the tick they are due at.
+*
+*/
+
+#ifndef REDSTONE_BITS_TIMINGWHEEL_H
+#define REDSTONE_BITS_TIMINGWHEEL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+
+/* Redstone namespace */
+namespace Redstone
+{
+
+
+	/**
+	 * @brief Hierarchical timing wheel
+	 *
+	 * Level 0 has a slot for each of the next 64 ticks.  Each higher level
+	 * has slots that are 64 times as wide as the level below it.  When the
+	 * clock reaches the start of a wide slot, its items are spread out into
+	 * the levels below.  Items due too far away wait in an overflow list.
+	 *
+	 * Adding an item and taking out a due item are both O(1).
+	 *
+	 * @tparam T	The type of the items
+	 */
+	template<typename T>
+	class TimingWheel
+	{
+
+	public:
+
+		/**
+		 * @brief Get the current time of the wheel
+		 * @returns The tick the wheel is at
+		 */
+		unsigned long long now() const
+		{
+			return this->_now;
+		}
+
+		/**
+		 * @brief Check whether there are any items in the wheel
+		 * @returns true if there are none
+		 */
+		bool empty() const
+		{
+			return this->_count == 0;
+		}
+
+		/**
+		 * @brief Get the number of items in the wheel
+		 * @returns The number of items waiting
+		 */
+		size_t size() const
+		{
+			return this->_count;
+		}
+
+		/**
+		 * @brief Get the heap memory the wheel holds
+		 * @note Slots keep their memory when emptied, so this only grows
+		 * @returns The bytes taken by all the slots
+		 */
+		size_t memoryUsage() const
+		{
+			size_t entries = this->_overflow.capacity() + this->_spare.capacity();
+			for (auto & level : this->_slots) {
+				for (auto & slot : level)
+					entries += slot.capacity();
+			}
+			return entries * sizeof(Entry);
+		}
+
+		/**
+		 * @brief Remove everything and set the clock
+		 * @param now	The tick to set the clock to
+		 */
+		void reset(unsigned long long now = 0)
+		{
+			for (auto & level : this->_slots) {
+				for (auto & slot : level)
+					slot.clear();
+			}
+			this->_overflow.clear();
+			this->_now = now;
+			this->_count = 0;
+		}
+
+		/**
+		 * @brief Add an item
+		 * @param item	The item to add
+		 * @param delay	How many ticks from now it is due, at least 1
+		 */
+		void schedule(const T & item, unsigned long long delay)
+		{
+			if (delay == 0)
+				delay = 1;
+			this->_insert(Entry{ item, this->_now + delay });
+			++ this->_count;
+		}
+
+		/**
+		 * @brief Get the tick the first item is due at
+		 * @warning Assumes the wheel is not empty
+		 * @returns The earliest tick that has an item due
+		 */
+		unsigned long long nextDue() const
+		{
+			// Each level only holds items past the slot the clock is in, and
+			// everything on a level comes before everything on the next one
+			for (int level = 0; level != LEVELS; ++level) {
+				for (size_t slot = _slotOf(this->_now, level) + 1; slot < SLOTS; ++slot) {
+					if (!this->_slots[level][slot].empty())
+						return _earliest(this->_slots[level][slot]);
+				}
+			}
+			return _earliest(this->_overflow);
+		}
+
+		/**
+		 * @brief Go through every item in the wheel, in no special order
+		 * @param visit	Called with each item and how many ticks until it's due
+		 * @tparam F	The type of the callback
+		 */
+		template<typename F>
+		void forEach(F visit) const
+		{
+			for (auto & level : this->_slots) {
+				for (auto & slot : level) {
+					for (auto & entry : slot)
+						visit(entry.item, entry.due - this->_now);
+				}
+			}
+			for (auto & entry : this->_overflow)
+				visit(entry.item, entry.due - this->_now);
+		}
+
+		/**
+		 * @brief Change or remove items, leaving them due when they were
+		 * @param change	Called with each item, which it may change, and
+		 *	returns false to remove it
+		 * @tparam F	The type of the callback
+		 */
+		template<typename F>
+		void rewrite(F change)
+		{
+			auto keep = [&](std::vector<Entry> & entries) {
+				auto end = std::remove_if(entries.begin(), entries.end(),
+					[&](Entry & entry) { return !change(entry.item); });
+				this->_count -= entries.end() - end;
+				entries.erase(end, entries.end());
+			};
+
+			for (auto & level : this->_slots) {
+				for (auto & slot : level)
+					keep(slot);
+			}
+			keep(this->_overflow);
+		}
+
+		/**
+		 * @brief Move the clock forward over ticks with nothing due
+		 * @warning Assumes nothing is due in the ticks being skipped
+		 * @param ticks	The number of ticks to move forward
+		 */
+		void skip(unsigned long long ticks)
+		{
+			// Take everything out, and put it back in relative to the new time
+			for (auto & level : this->_slots) {
+				for (auto & slot : level) {
+					this->_spare.insert(this->_spare.end(), slot.begin(), slot.end());
+					slot.clear();
+				}
+			}
+			this->_spare.insert(this->_spare.end(), this->_overflow.begin(), this->_overflow.end());
+			this->_overflow.clear();
+
+			this->_now += ticks;
+			for (auto & entry : this->_spare)
+				this->_insert(entry);
+			this->_spare.clear();
+		}
+
+		/**
+		 * @brief Move the clock forward by one tick
+		 * @param due	Called with each item that is due at the new tick
+		 * @tparam F	The type of the callback
+		 */
+		template<typename F>
+		void advance(F due)
+		{
+			++ this->_now;
+
+			// Spread out wider slots that start now, widest first
+			if ((this->_now & MAX_MASK) == 0)
+				this->_cascade(this->_overflow);
+			for (int level = LEVELS - 1; level != 0; --level) {
+				if ((this->_now & ((1ull << (level * BITS)) - 1)) == 0)
+					this->_cascade(this->_slots[level][this->_slotOf(this->_now, level)]);
+			}
+
+			// Everything left in this slot is due now
+			std::vector<Entry> & slot = this->_slots[0][this->_now & MASK];
+			this->_count -= slot.size();
+			for (auto & entry : slot)
+				due(entry.item);
+			slot.clear();
+		}
+
+
+	private:
+
+		/* Types */
+
+		/**
+		 * @brief An item and the tick it is due at
+		 */
+		struct Entry
+		{
+			T item;
+			unsigned long long due;
+		};
+
+
+		/* Constants */
+
+		static const int BITS = 6;
+		static const int SLOTS = 1 << BITS;
+		static const int LEVELS = 4;
+		static const unsigned long long MASK = SLOTS - 1;
+		static const unsigned long long MAX_MASK = (1ull << (BITS * LEVELS)) - 1;
+
+
+		/* Helper functions */
+
+		/**
+		 * @brief Get the slot of a tick at some level
+		 * @param tick	The tick
+		 * @param level	The level of the wheel
+		 * @returns The index of the slot
+		 */
+		static size_t _slotOf(unsigned long long tick, int level)
+		{
+			return static_cast<size_t>((tick >> (level * BITS)) & MASK);
+		}
+
+		/**
+		 * @brief Find the earliest due tick in a list of entries
+		 * @param entries	The entries to look through
+		 * @returns The earliest due tick, or the latest tick if none
+		 */
+		static unsigned long long _earliest(const std::vector<Entry> & entries)
+		{
+			unsigned long long due = ~0ull;
+			for (auto & entry : entries) {
+				if (entry.due < due)
+					due = entry.due;
+			}
+			return due;
+		}
+
+		/**
+		 * @brief Put an entry in the slot it belongs in
+		 * @param entry	The entry to put away
+		 */
+		void _insert(const Entry & entry)
+		{
+			// Lowest level on which it shares the wide slot with now
+			for (int level = 0; level != LEVELS; ++level) {
+				if ((entry.due >> ((level + 1) * BITS)) == (this->_now >> ((level + 1) * BITS))) {
+					this->_slots[level][_slotOf(entry.due, level)].push_back(entry);
+					return;
+				}
+			}
+			this->_overflow.push_back(entry);
+		}
+
+		/**
+		 * @brief Spread the entries in a slot out into the levels below
+		 * @param slot	The slot to empty
+		 */
+		void _cascade(std::vector<Entry> & slot)
+		{
+			// Swap through a spare so neither vector loses its memory
+			this->_spare.swap(slot);
+			for (auto & entry : this->_spare)
+				this->_insert(entry);
+			this->_spare.clear();
+		}
+
+
+	private:
+
+		/* Data */
+
+		std::vector<Entry> _slots[LEVELS][SLOTS];
+		std::vector<Entry> _overflow;
+		std::vector<Entry> _spare;
+
+		unsigned long long _now = 0;
+		size_t _count = 0;
+
+	};
+
+
+}
+
+
+#endif
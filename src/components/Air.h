@@ -25,11 +25,18 @@ namespace Redstone
 	* This class is a component that represents air in Minecraft.
 	*
 	*/
-	class Air : public Component
+	class Air final : public Component
 	{
 
 	public:
 
+		/* Constants */
+
+		/**
+		 * @brief The ID of the class, for componentCast
+		 */
+		static const Component::ID TYPE = Component::ID::AIR;
+
 
 		/* Functions */
 
@@ -46,6 +53,45 @@ namespace Redstone
 			return new Air(*this);
 		}
 
+		/**
+		* @brief Clone the component into some memory
+		* @param memory	getSize() bytes to build the clone in
+		* @returns The clone
+		*/
+		Air * cloneAt(void * memory) const
+		{
+			return new (memory) Air(*this);
+		}
+
+		/**
+		* @brief Get the number of bytes cloneAt needs
+		* @returns The size of the class
+		*/
+		size_t getSize() const
+		{
+			return sizeof(Air);
+		}
+
+		/**
+		* @brief Get the instance that maps can share
+		* @warning Don't delete it!
+		* @returns The shared instance
+		*/
+		static Air * shared()
+		{
+			static Air instance;
+			return &instance;
+		}
+
+		/**
+		* @brief Get whether this is the shared instance
+		* @returns true if it is
+		*/
+		bool isShared() const
+		{
+			return this == shared();
+		}
+
 		/**
 		* @brief Update the component
 		* @brief engine	The engine being used
@@ -60,7 +106,7 @@ namespace Redstone
 		*/
 		virtual Component::ID getId() const
 		{
-			return Component::ID::AIR;
+			return TYPE;
 		}
 
 		/**
@@ -25,11 +25,18 @@ namespace Redstone
 	* This class is a component that represents a Minecraft glass block.
 	*
 	*/
-	class GlassBlock : public Component
+	class GlassBlock final : public Component
 	{
 
 	public:
 
+		/* Constants */
+
+		/**
+		 * @brief The ID of the class, for componentCast
+		 */
+		static const Component::ID TYPE = Component::ID::GLASS_BLOCK;
+
 
 		/* Functions */
 
@@ -46,6 +53,45 @@ namespace Redstone
 			return new GlassBlock(*this);
 		}
 
+		/**
+		* @brief Clone the component into some memory
+		* @param memory	getSize() bytes to build the clone in
+		* @returns The clone
+		*/
+		GlassBlock * cloneAt(void * memory) const
+		{
+			return new (memory) GlassBlock(*this);
+		}
+
+		/**
+		* @brief Get the number of bytes cloneAt needs
+		* @returns The size of the class
+		*/
+		size_t getSize() const
+		{
+			return sizeof(GlassBlock);
+		}
+
+		/**
+		* @brief Get the instance that maps can share
+		* @warning Don't delete it!
+		* @returns The shared instance
+		*/
+		static GlassBlock * shared()
+		{
+			static GlassBlock instance;
+			return &instance;
+		}
+
+		/**
+		* @brief Get whether this is the shared instance
+		* @returns true if it is
+		*/
+		bool isShared() const
+		{
+			return this == shared();
+		}
+
 		/**
 		* @brief Update the component
 		* @brief engine	The engine being used
@@ -60,7 +106,7 @@ namespace Redstone
 		*/
 		virtual Component::ID getId() const
 		{
-			return Component::ID::GLASS_BLOCK;
+			return TYPE;
 		}
 
 		/**
@@ -24,11 +24,18 @@ namespace Redstone
 	* This class is a component that represents a Minecraft redstone block.
 	*
 	*/
-	class RedstoneBlock : public Component
+	class RedstoneBlock final : public Component
 	{
 
 	public:
 
+		/* Constants */
+
+		/**
+		 * @brief The ID of the class, for componentCast
+		 */
+		static const Component::ID TYPE = Component::ID::REDSTONE_BLOCK;
+
 
 		/* Functions */
 
@@ -45,6 +52,45 @@ namespace Redstone
 			return new RedstoneBlock(*this);
 		}
 
+		/**
+		* @brief Clone the component into some memory
+		* @param memory	getSize() bytes to build the clone in
+		* @returns The clone
+		*/
+		RedstoneBlock * cloneAt(void * memory) const
+		{
+			return new (memory) RedstoneBlock(*this);
+		}
+
+		/**
+		* @brief Get the number of bytes cloneAt needs
+		* @returns The size of the class
+		*/
+		size_t getSize() const
+		{
+			return sizeof(RedstoneBlock);
+		}
+
+		/**
+		* @brief Get the instance that maps can share
+		* @warning Don't delete it!
+		* @returns The shared instance
+		*/
+		static RedstoneBlock * shared()
+		{
+			static RedstoneBlock instance;
+			return &instance;
+		}
+
+		/**
+		* @brief Get whether this is the shared instance
+		* @returns true if it is
+		*/
+		bool isShared() const
+		{
+			return this == shared();
+		}
+
 		/**
 		* @brief Update the component
 		* @brief engine	The engine being used
@@ -59,7 +105,7 @@ namespace Redstone
 		*/
 		virtual Component::ID getId() const
 		{
-			return Component::ID::REDSTONE_BLOCK;
+			return TYPE;
 		}
 
 		/**
@@ -13,7 +13,9 @@
 #include "RedstoneTorch.h"
 #include "SolidBlock.h"
 #include "Switch.h"
+#include "../_bits/ComponentSet.h"
 #include <algorithm>
+#include <vector>
 
 
 /**
@@ -28,24 +30,18 @@ void Redstone::RedstoneDust::update(
 	// We'll test against these for state changes
 	int oldLevel = this->_level;
 	int oldDirection = this->_direction;
-	this->_level = 0;
-	this->_direction = 0;
 
 	// Find neighbors that may update us
-	for (auto d : this->_diagonals)
-		d = true;
-	this->_processNeighbors(engine.getMap(), coords);
-	this->_processDiagonals(engine.getMap(), coords);
-
-	// If we get updated, update surrounding
-	if (oldLevel != this->_level || oldDirection != this->_direction) {
-		this->updateSurrounding(engine, coords);
-		this->_updateDiagonals(engine, coords);
-	}
-	else {
-		this->_level = oldLevel;
-		this->_direction = oldDirection;
-	}
+	Component * around[DustGraph::AROUND];
+	_lookAround(Map::Cursor(engine.getMap(), coords), around);
+	this->_recompute(coords, around);
+
+	// If we get updated, so may the rest of the wire
+	bool changed = oldLevel != this->_level || oldDirection != this->_direction;
+	this->_level = oldLevel;
+	this->_direction = oldDirection;
+	if (changed)
+		this->_updateWire(engine, coords);
 }
 
 
@@ -59,7 +55,7 @@ bool Redstone::RedstoneDust::operator==(const Redstone::Component & b) const
 	if (b.getId() != this->getId())
 		return false;
 
-	const RedstoneDust * bPtr = dynamic_cast<const RedstoneDust*>(&b);
+	const RedstoneDust * bPtr = componentCast<RedstoneDust>(&b);
 	if (this->_direction != bPtr->_direction)
 		return false;
 	if (this->_level != bPtr->_level)
@@ -69,6 +65,58 @@ bool Redstone::RedstoneDust::operator==(const Redstone::Component & b) const
 }
 
 
+/**
+* @brief Get whether a change in a neighbour can change us
+* @param neighbor	The component next to us
+* @param direction	The direction from the neighbour towards us
+* @returns true if it may change our state
+*/
+bool Redstone::RedstoneDust::isSensitiveTo(
+	const Redstone::Component & neighbor,
+	const Redstone::Map::Direction & /*direction*/) const
+{
+	// We read everything in _processNeighbor from any side
+	switch (neighbor.getId()) {
+	case Component::ID::REDSTONE_BLOCK:
+	case Component::ID::REDSTONE_DUST:
+	case Component::ID::REDSTONE_TORCH:
+	case Component::ID::SOLID_BLOCK:
+	case Component::ID::SWITCH:
+		return true;
+	default:
+		return false;
+	}
+}
+
+
+/**
+* @brief Get a number that sums up the state of the component
+* @returns The level, direction, and which diagonals are connected
+*/
+unsigned Redstone::RedstoneDust::getStateKey() const
+{
+	unsigned key = this->_level | (this->_direction << 4);
+	for (int i = 0; i != 8; ++i) {
+		if (this->_diagonals[i])
+			key |= 0x100 << i;
+	}
+	return key;
+}
+
+
+/**
+* @brief Set the state from a key made by getStateKey
+* @param key	The state key
+*/
+void Redstone::RedstoneDust::setStateKey(unsigned key)
+{
+	this->_level = key & 0xF;
+	this->_direction = (key >> 4) & 0xF;
+	for (int i = 0; i != 8; ++i)
+		this->_diagonals[i] = (key & (0x100 << i)) != 0;
+}
+
+
 /**
 * @brief Get whether the redstone points in some direction
 * @param direction	The direction to test
@@ -96,58 +144,39 @@ bool Redstone::RedstoneDust::hasDirection(const Map::Direction & direction) cons
 
 /**
  * @brief Check to see if surrounding blocks will change our state
- * @param map		The map being used
  * @param coords	The current coordinates
+ * @param around	What is around us, in the order of DustGraph::offset
  */
 void Redstone::RedstoneDust::_processNeighbors(
-	Redstone::Map & map, 
-	const Redstone::Map::Coordinates & coords)
+	const Redstone::Map::Coordinates & coords,
+	const Redstone::Component * const around[])
 {
-	// We need this for all six directions
-	auto process = [&](int x, int y, int z, Map::Direction direction) {
-		Map::Coordinates test_coords = coords;
-		test_coords.x += x;
-		test_coords.y += y;
-		test_coords.z += z;
-		this->_processNeighbor(map.get(test_coords), direction, test_coords);
+	// The direction towards us, from each face
+	static const Map::Direction directions[6] = {
+		Map::Direction::WEST, Map::Direction::EAST,
+		Map::Direction::NORTH, Map::Direction::SOUTH,
+		Map::Direction::DOWN, Map::Direction::UP
 	};
 
-	// Now let's process surrounding blocks
-	process(1, 0, 0, Map::Direction::WEST);
-	process(-1, 0, 0, Map::Direction::EAST);
-	process(0, 0, 1, Map::Direction::NORTH);
-	process(0, 0, -1, Map::Direction::SOUTH);
-	process(0, 1, 0, Map::Direction::DOWN);
-	process(0, -1, 0, Map::Direction::UP);
+	for (int k = 0; k != 6; ++k)
+		this->_processNeighbor(around[k], directions[k], DustGraph::around(coords, k));
 }
 
 
 /**
  * @brief Process diagonals, if they are redstone
- * @param map		The map being used
- * @param coords	The current coordinates
+ * @param around	What is around us, in the order of DustGraph::offset
  */
 void Redstone::RedstoneDust::_processDiagonals(
-	Redstone::Map & map,
-	const Redstone::Map::Coordinates & coords)
+	const Redstone::Component * const around[])
 {
 	for (int i = 0; i != 8; ++i) {
 		if (this->_diagonals[i] == false)
 			continue;
 
-		// Figure out coordinates
-		Map::Coordinates test_coords = coords;
-		test_coords.y += (i < 4) ? 1 : -1;
-		switch (i % 4) {
-		case 0: ++test_coords.z; break;
-		case 1: ++test_coords.x; break;
-		case 2: --test_coords.z; break;
-		case 3: --test_coords.x; break;
-		}
-
 		// Verify it is redstone
 		this->_diagonals[i] = false;
-		Component * test_comp = map.get(test_coords);
+		const Component * test_comp = around[6 + i];
 		if (test_comp == nullptr)
 			continue;
 		if (test_comp->getId() != Component::ID::REDSTONE_DUST)
@@ -158,7 +187,7 @@ void Redstone::RedstoneDust::_processDiagonals(
 		this->_direction |= (1 << (i % 4));
 
 		// Process signal
-		int newLevel = dynamic_cast<const RedstoneDust *>(test_comp)->getLevel() - 1;
+		int newLevel = componentCast<RedstoneDust>(test_comp)->getLevel() - 1;
 		this->_level = std::max(this->_level, newLevel);
 	}
 }
@@ -215,38 +244,240 @@ void Redstone::RedstoneDust::_processNeighbor(
 
 
 /**
- * @brief Update surrounding diagonals
+ * @brief Work out our state from scratch from what's around us
+ * @param coords	The current coordinates
+ * @param around	What is around us, in the order of DustGraph::offset
+ */
+void Redstone::RedstoneDust::_recompute(
+	const Redstone::Map::Coordinates & coords,
+	const Redstone::Component * const around[])
+{
+	this->_level = 0;
+	this->_direction = 0;
+	for (auto & d : this->_diagonals)
+		d = true;
+	this->_processNeighbors(coords, around);
+	this->_processDiagonals(around);
+}
+
+
+/**
+ * @brief Get what is around a location
+ * @param cursor	A cursor at the location
+ * @param around	Filled with DustGraph::AROUND components, or nullptr
+ */
+void Redstone::RedstoneDust::_lookAround(
+	const Redstone::Map::Cursor & cursor,
+	Redstone::Component * around[])
+{
+	for (int k = 0; k != DustGraph::AROUND; ++k) {
+		const int * o = DustGraph::offset(k);
+		around[k] = cursor.at(o[0], o[1], o[2]);
+	}
+}
+
+
+/**
+ * @brief Find all of the dust connected to us
+ * @param map	The map we are in
+ * @param coords	Our coordinates
+ * @returns The wire, ready for DustGraph::insert
+ */
+Redstone::DustGraph::Wire Redstone::RedstoneDust::_findWire(
+	Redstone::Map & map,
+	const Redstone::Map::Coordinates & coords)
+{
+	const int AROUND = DustGraph::AROUND;
+	DustGraph::Wire wire;
+	std::vector<int> links;		// AROUND per dust: the dust there, or -1
+	std::vector<int> oldLevels;
+
+	// While the wire is being found, the level of each dust found holds
+	// -1 - its index instead.  They are all put back after.
+	auto add = [&](const Map::Coordinates & at, RedstoneDust * dust) {
+		if (dust->_level < 0)
+			return -1 - dust->_level;
+
+		wire.coords.push_back(at);
+		wire.dust.push_back(dust);
+		oldLevels.push_back(dust->_level);
+		dust->_level = -1 - static_cast<int>(wire.size() - 1);
+		return static_cast<int>(wire.size()) - 1;
+	};
+
+	add(coords, this);
+	for (size_t n = 0; n != wire.size(); ++n) {
+		wire.around.resize((n + 1) * AROUND);
+		Component ** around = &wire.around[n * AROUND];
+		_lookAround(Map::Cursor(map, wire.coords[n]), around);
+		for (int k = 0; k != AROUND; ++k) {
+			int link = -1;
+			if (around[k] && around[k]->getId() == Component::ID::REDSTONE_DUST)
+				link = add(DustGraph::around(wire.coords[n], k), componentCast<RedstoneDust>(around[k]));
+			links.push_back(link);
+		}
+	}
+	for (size_t n = 0; n != wire.size(); ++n)
+		wire.dust[n]->_level = oldLevels[n];
+
+	// Which diagonals each dust reads comes from working out its state.
+	// Do that on a copy, so the dust itself is left alone.
+	std::vector<char> reads(links.size());
+	for (size_t n = 0; n != wire.size(); ++n) {
+		RedstoneDust copy(*wire.dust[n]);
+		copy._recompute(wire.coords[n], &wire.around[n * AROUND]);
+		for (int k = 0; k != AROUND; ++k) {
+			reads[n * AROUND + k] = links[n * AROUND + k] != -1
+				&& (k < 6 || copy._diagonals[k - 6]);
+		}
+	}
+
+	// The readers of dust m are readers[first[m]] to readers[first[m + 1]]
+	wire.first.assign(wire.size() + 1, 0);
+	for (size_t i = 0; i != links.size(); ++i) {
+		if (reads[i])
+			++wire.first[links[i] + 1];
+	}
+	for (size_t m = 0; m != wire.size(); ++m)
+		wire.first[m + 1] += wire.first[m];
+	wire.readers.resize(wire.first.back());
+	std::vector<int> next(wire.first.begin(), wire.first.end() - 1);
+	for (size_t i = 0; i != links.size(); ++i) {
+		if (reads[i])
+			wire.readers[next[links[i]]++] = static_cast<int>(i / AROUND);
+	}
+	return wire;
+}
+
+
+/**
+ * @brief Work out the levels of the whole wire we are part of
  * @param engine	The engine being used
- * @param coords	The coordinates at the center
+ * @param coords	Our coordinates
  */
-void Redstone::RedstoneDust::_updateDiagonals(
+void Redstone::RedstoneDust::_updateWire(
 	Redstone::Engine & engine,
 	const Redstone::Map::Coordinates & coords)
 {
-	for (int i = 0; i != 8; ++i) {
-		if (this->_diagonals[i] == false)
-			continue;
+	const int AROUND = DustGraph::AROUND;
+
+	Map & map = engine.getMap();
+	DustGraph & graph = this->dustGraph(engine);
+	const DustGraph::Wire * wire = graph.find(map, coords);
+	if (wire == nullptr)
+		wire = &graph.insert(map, this->_findWire(map, coords));
+
+	// The engine is already watching us, but has to be told about the
+	// rest of the wire before it changes
+	DustGraph::Scratch & scratch = graph.scratch();
+	size_t count = wire->size();
+	scratch.oldLevels.resize(count);
+	scratch.oldDirections.resize(count);
+	scratch.oldVisible.resize(count);
+	for (size_t n = 0; n != count; ++n) {
+		RedstoneDust * dust = wire->dust[n];
+		scratch.oldLevels[n] = dust->_level;
+		scratch.oldDirections[n] = dust->_direction;
+		scratch.oldVisible[n] = (dust == this) ? 0 : this->beginChange(engine, wire->coords[n]);
+	}
 
-		// Figure out coordinates
-		Map::Coordinates update_coords = coords;
-		update_coords.y += (i < 4) ? 1 : -1;
-		switch (i % 4) {
-		case 0: ++update_coords.z; break;
-		case 1: ++update_coords.x; break;
-		case 2: --update_coords.z; break;
-		case 3: --update_coords.x; break;
-		}
+	// With the wire dark, all that's left is what powers each dust from
+	// outside the wire.  That's as low as any of them can end up.
+	for (size_t n = 0; n != count; ++n)
+		wire->dust[n]->_level = 0;
+	std::vector<unsigned char> & levels = scratch.levels;
+	levels.resize(count);
+	for (size_t n = 0; n != count; ++n) {
+		RedstoneDust * dust = wire->dust[n];
+		dust->_recompute(wire->coords[n], &wire->around[n * AROUND]);
+		levels[n] = static_cast<unsigned char>(dust->_level);
+	}
 
-		/* // done in _processDiagonals
-		Component * update_comp = engine.getMap().get(update_coords);
-		if (update_comp == nullptr)
-			continue;
-		if (update_comp->getId() != Component::ID::REDSTONE_DUST)
+	// Sort the dust by level, strongest first, with start[level] being
+	// where each level begins
+	int start[17] = {};
+	for (size_t n = 0; n != count; ++n)
+		++start[15 - levels[n] + 1];
+	for (int i = 1; i != 17; ++i)
+		start[i] += start[i - 1];
+	scratch.order.resize(count);
+	int fill[16];
+	std::copy(start, start + 16, fill);
+	for (size_t n = 0; n != count; ++n)
+		scratch.order[fill[15 - levels[n]]++] = static_cast<int>(n);
+
+	// Spread the power out, strongest first, so each dust is raised
+	// straight to its final level.  A level is spread from the dust that
+	// started there, then from the dust the level above raised to it.
+	const int * first = wire->first.data();
+	const int * readers = wire->readers.data();
+	scratch.raised.clear();
+	for (int level = 15; level > 1; --level) {
+		scratch.next.clear();
+		auto spread = [&](int n) {
+			if (levels[n] != level)
+				return;
+			for (int j = first[n]; j != first[n + 1]; ++j) {
+				int m = readers[j];
+				if (levels[m] < level - 1) {
+					levels[m] = static_cast<unsigned char>(level - 1);
+					scratch.next.push_back(m);
+				}
+			}
+		};
+		for (int i = start[15 - level]; i != start[15 - level + 1]; ++i)
+			spread(scratch.order[i]);
+		for (int n : scratch.raised)
+			spread(n);
+		scratch.raised.swap(scratch.next);
+	}
+
+	// The wire is done, so now wake up whatever it powers
+	for (size_t n = 0; n != count; ++n) {
+		RedstoneDust * dust = wire->dust[n];
+		dust->_level = levels[n];
+		if (dust != this)
+			this->endChange(engine, wire->coords[n], scratch.oldVisible[n]);
+		if (dust->_level != scratch.oldLevels[n] || dust->_direction != scratch.oldDirections[n])
+			dust->_updateOthers(engine, wire->coords[n], &wire->around[n * AROUND]);
+	}
+}
+
+
+/**
+ * @brief Update the surrounding components that aren't dust
+ * @param engine	The engine being used
+ * @param coords	The coordinates at the center
+ * @param around	What is around the center, in the order of DustGraph::offset
+ */
+void Redstone::RedstoneDust::_updateOthers(
+	Redstone::Engine & engine,
+	const Redstone::Map::Coordinates & coords,
+	const Redstone::Component * const around[])
+{
+	// The faces, in the order they have always been woken in, and the
+	// direction from us towards each of them (see isSensitiveTo)
+	static const int faces[6] = { 1, 0, 3, 2, 5, 4 };
+	static const Map::Direction directions[6] = {
+		Map::Direction::EAST, Map::Direction::WEST,
+		Map::Direction::SOUTH, Map::Direction::NORTH,
+		Map::Direction::UP, Map::Direction::DOWN
+	};
+
+	for (int k : faces) {
+		const Component * neighbor = around[k];
+		if (neighbor == nullptr || neighbor->getId() == Component::ID::REDSTONE_DUST)
 			continue;
-		*/
 
-		// Mark it to be updated!
-		this->markUpdate(engine, update_coords);
+#ifdef REDSTONE_VIRTUAL_DISPATCH
+		bool sensitive = neighbor->isSensitiveTo(*this, directions[k]);
+#else
+		bool sensitive = KnownComponents::visit(*neighbor, [&](const auto & n) {
+			return n.isSensitiveTo(*this, directions[k]);
+		});
+#endif
+		if (sensitive)
+			this->markUpdate(engine, DustGraph::around(coords, k));
 	}
 }
 
@@ -284,7 +515,7 @@ void Redstone::RedstoneDust::_onSolidAbove(
 		this->_diagonals[i] = false;
 
 	// Second, let's see if it's strongly powered
-	if (dynamic_cast<const SolidBlock *>(component)->isStronglyPowered())
+	if (componentCast<SolidBlock>(component)->isStronglyPowered())
 		this->_level = 15;
 }
 
@@ -298,7 +529,7 @@ void Redstone::RedstoneDust::_onSolidBelow(
 	const Redstone::Component * component,
 	const Redstone::Map::Coordinates & coords)
 {
-	if (dynamic_cast<const SolidBlock *>(component)->isStronglyPowered())
+	if (componentCast<SolidBlock>(component)->isStronglyPowered())
 		this->_level = 15;
 }
 
@@ -323,7 +554,7 @@ void Redstone::RedstoneDust::_onSolidBeside(
 	}
 
 	// Second, let's see if it's strongly powered
-	if (dynamic_cast<const SolidBlock *>(component)->isStronglyPowered())
+	if (componentCast<SolidBlock>(component)->isStronglyPowered())
 		this->_level = 15;
 }
 
@@ -343,7 +574,7 @@ void Redstone::RedstoneDust::_onRedstoneDustBeside(
 	this->_attachDirection(direction);
 
 	// Second, set our level
-	int newLevel = dynamic_cast<const RedstoneDust *>(component)->getLevel() - 1;
+	int newLevel = componentCast<RedstoneDust>(component)->getLevel() - 1;
 	this->_level = std::max(this->_level, newLevel);
 }
 
@@ -370,7 +601,7 @@ void Redstone::RedstoneDust::_onSwitchBeside(
 	const Redstone::Map::Direction & direction)
 {
 	this->_attachDirection(direction);
-	if (dynamic_cast<const Switch *>(component)->isOn())
+	if (componentCast<Switch>(component)->isOn())
 		this->_level = 15;
 }
 
@@ -385,7 +616,7 @@ void Redstone::RedstoneDust::_onTorchBeside(
 	const Redstone::Map::Direction & direction)
 {
 	this->_attachDirection(direction);
-	if (dynamic_cast<const RedstoneTorch *>(component)->isOn())
+	if (componentCast<RedstoneTorch>(component)->isOn())
 		this->_level = 15;
 }
 
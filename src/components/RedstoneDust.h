@@ -12,6 +12,7 @@
 
 #include "../Map.h"
 #include "../Component.h"
+#include "../_bits/DustGraph.h"
 
 
 /* Redstone namespace */
@@ -25,11 +26,18 @@ namespace Redstone
 	* This class is a component that represents Minecraft redstone dust.
 	*
 	*/
-	class RedstoneDust : public Component
+	class RedstoneDust final : public Component
 	{
 
 	public:
 
+		/* Constants */
+
+		/**
+		 * @brief The ID of the class, for componentCast
+		 */
+		static const Component::ID TYPE = Component::ID::REDSTONE_DUST;
+
 
 		/* Functions */
 
@@ -46,6 +54,25 @@ namespace Redstone
 			return new RedstoneDust(*this);
 		}
 
+		/**
+		* @brief Clone the component into some memory
+		* @param memory	getSize() bytes to build the clone in
+		* @returns The clone
+		*/
+		RedstoneDust * cloneAt(void * memory) const
+		{
+			return new (memory) RedstoneDust(*this);
+		}
+
+		/**
+		* @brief Get the number of bytes cloneAt needs
+		* @returns The size of the class
+		*/
+		size_t getSize() const
+		{
+			return sizeof(RedstoneDust);
+		}
+
 		/**
 		* @brief Update the component
 		* @brief engine	The engine being used
@@ -59,7 +86,7 @@ namespace Redstone
 		*/
 		virtual Component::ID getId() const
 		{
-			return Component::ID::REDSTONE_DUST;
+			return TYPE;
 		}
 
 		/**
@@ -69,6 +96,47 @@ namespace Redstone
 		*/
 		bool operator==(const Component & b) const;
 
+		/**
+		* @brief Get whether the component gives off power or changes by itself
+		* @returns true, since it does
+		*/
+		bool isActive() const
+		{
+			return true;
+		}
+
+		/**
+		* @brief Get whether a change in a neighbour can change us
+		* @param neighbor	The component next to us
+		* @param direction	The direction from the neighbour towards us
+		* @returns true if it may change our state
+		*/
+		bool isSensitiveTo(
+			const Component & neighbor,
+			const Map::Direction & direction) const;
+
+		/**
+		* @brief Get a number that sums up the state of the component
+		* @returns The level, direction, and which diagonals are connected
+		*/
+		unsigned getStateKey() const;
+
+		/**
+		* @brief Set the state from a key made by getStateKey
+		* @note For initialization only, please.
+		* @param key	The state key
+		*/
+		void setStateKey(unsigned key);
+
+		/**
+		* @brief Get a number that sums up what can be seen of the component
+		* @returns The level and direction
+		*/
+		unsigned getVisibleState() const
+		{
+			return this->_level | (this->_direction << 4);
+		}
+
 
 		/**
 		 * @brief Set the power level
@@ -116,24 +184,73 @@ namespace Redstone
 
 		/**
 		 * @brief Check to see if surrounding blocks will change our state
-		 * @param map		The map being used
 		 * @param coords	The current coordinates
+		 * @param around	What is around us, in the order of DustGraph::offset
 		 */
-		void _processNeighbors(Map & map, const Map::Coordinates & coords);
+		void _processNeighbors(
+			const Map::Coordinates & coords,
+			const Component * const around[]);
 
 		/**
 		 * @brief Process diagonals, if they are redstone
-		 * @param map		The map being used
+		 * @param around	What is around us, in the order of DustGraph::offset
+		 */
+		void _processDiagonals(const Component * const around[]);
+
+		/**
+		 * @brief Work out our state from scratch from what's around us
 		 * @param coords	The current coordinates
+		 * @param around	What is around us, in the order of DustGraph::offset
 		 */
-		void _processDiagonals(Map & map, const Map::Coordinates & coords);
+		void _recompute(
+			const Map::Coordinates & coords,
+			const Component * const around[]);
+
+		/**
+		 * @brief Get what is around a location
+		 * @param cursor	A cursor at the location
+		 * @param around	Filled with DustGraph::AROUND components, or nullptr
+		 */
+		static void _lookAround(const Map::Cursor & cursor, Component * around[]);
+
+		/**
+		 * @brief Find all of the dust connected to us
+		 *
+		 * Each dust reads its faces, and the diagonals it's connected to.
+		 * That depends only on what is where, so it is worked out here
+		 * too, without changing any of the dust.
+		 *
+		 * @param map	The map we are in
+		 * @param coords	Our coordinates
+		 * @returns The wire, ready for DustGraph::insert
+		 */
+		DustGraph::Wire _findWire(Map & map, const Map::Coordinates & coords);
+
+		/**
+		 * @brief Work out the levels of the whole wire we are part of
+		 *
+		 * The wire is every dust connected to us.  Its levels are worked
+		 * out in one pass going out from the power sources, so each dust
+		 * is only changed once, to its final level.  The wire is kept in
+		 * the engine's DustGraph, so it is only found again once something
+		 * is built or broken near it.
+		 *
+		 * @param engine	The engine being used
+		 * @param coords	Our coordinates
+		 */
+		void _updateWire(Engine & engine, const Map::Coordinates & coords);
 
 		/**
-		 * @brief Updated surrounding diagonals
+		 * @brief Update the surrounding components that aren't dust
 		 * @param engine	The engine being used
 		 * @param coords	The coordinates at the center
+		 * @param around	What is around the center, in the order of
+		 *	DustGraph::offset
 		 */
-		void _updateDiagonals(Engine & engine, const Map::Coordinates & coords);
+		void _updateOthers(
+			Engine & engine,
+			const Map::Coordinates & coords,
+			const Component * const around[]);
 
 		/**
 		 * @brief Make us point from a power source
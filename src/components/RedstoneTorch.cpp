@@ -64,36 +64,45 @@ void Redstone::RedstoneTorch::update(
 
 	// Process that block
 	this->_processNeighbor(map.get(test_coords), test_dir, test_coords);
-
-	// If we updated
-	if (oldIsOn != this->_isOn) {
-		oldIsOn = this->_isOn;
-
-		// On after 1
-		if (this->_isOn) {
+	bool wantsOn = this->_isOn;
+	this->_isOn = oldIsOn;
+
+	// Are we in the middle of waiting to turn off?  The tick we saved may be
+	// from some other engine's clock, so only trust it while this engine
+	// still has a wake-up for us, or it is the wake-up.
+	int tick = engine.getTickNumber();
+	bool waiting = this->_offTick != -1 && this->_offTick - tick <= 3
+		&& (tick >= this->_offTick || this->isUpdateScheduled(engine, coords));
+
+	// On after 1
+	if (wantsOn) {
+		if (!oldIsOn) {
+			this->_isOn = true;
 			this->updateSurrounding(engine, coords);
 		}
 
-		// Off after 3
-		else if (!this->_prevStates[2]) {
-			this->updateSurrounding(engine, coords);
-		}
+		// The wait is over, and we don't need to turn off after all
+		if (!waiting || tick >= this->_offTick)
+			this->_offTick = -1;
+	}
 
-		// Can't turn off yet, so wait until the next tick
-		else {
-			this->_isOn = true;
-			this->markNextUpdate(engine, coords);
+	// Off after 3
+	else if (oldIsOn) {
+
+		// Start waiting, and have the engine wake us up when it's time
+		if (!waiting) {
+			this->_offTick = tick + 3;
+			this->scheduleUpdate(engine, coords, 3);
 		}
 
-	}
+		// Done waiting
+		else if (tick >= this->_offTick) {
+			this->_isOn = false;
+			this->_offTick = -1;
+			this->updateSurrounding(engine, coords);
+		}
 
-	// Shift previous states, if not already done this game tick
-	if (engine.getTickNumber() != this->_oldTickNumber) {
-		this->_prevStates[2] = this->_prevStates[1];
-		this->_prevStates[1] = this->_prevStates[0];
-		this->_oldTickNumber = engine.getTickNumber();
 	}
-	this->_prevStates[0] = oldIsOn;
 }
 
 
@@ -107,7 +116,7 @@ bool Redstone::RedstoneTorch::operator==(const Redstone::Component & b) const
 	if (b.getId() != this->getId())
 		return false;
 
-	auto bPtr = dynamic_cast<const RedstoneTorch *>(&b);
+	auto bPtr = componentCast<RedstoneTorch>(&b);
 	if (bPtr->isOn() != this->isOn())
 		return false;
 	if (bPtr->getDirection() != this->getDirection())
@@ -117,6 +126,34 @@ bool Redstone::RedstoneTorch::operator==(const Redstone::Component & b) const
 }
 
 
+/**
+* @brief Get whether a change in a neighbour can change us
+* @param neighbor	The component next to us
+* @param direction	The direction from the neighbour towards us
+* @returns true if it may change our state
+*/
+bool Redstone::RedstoneTorch::isSensitiveTo(
+	const Redstone::Component & neighbor,
+	const Redstone::Map::Direction & direction) const
+{
+	// Only the block to which we're attached will change our state
+	Map::Direction fromAttached;
+	switch (this->_direction) {
+	case Map::Direction::DOWN: fromAttached = Map::Direction::UP; break;
+	case Map::Direction::SOUTH: fromAttached = Map::Direction::NORTH; break;
+	case Map::Direction::EAST: fromAttached = Map::Direction::WEST; break;
+	case Map::Direction::NORTH: fromAttached = Map::Direction::SOUTH; break;
+	case Map::Direction::WEST: fromAttached = Map::Direction::EAST; break;
+	default: return false;
+	}
+	if (direction != fromAttached)
+		return false;
+
+	return neighbor.getId() == Component::ID::SOLID_BLOCK
+		|| neighbor.getId() == Component::ID::REDSTONE_BLOCK;
+}
+
+
 /* Helper functions */
 
 
@@ -143,7 +180,7 @@ void Redstone::RedstoneTorch::_processNeighbor(
 
 	case Component::ID::SOLID_BLOCK:
 
-		if (dynamic_cast<const SolidBlock *>(component)->getPowerLevel())
+		if (componentCast<SolidBlock>(component)->getPowerLevel())
 			this->_isOn = false;
 		break;
 
@@ -13,6 +13,9 @@
 * My results are that redstone torches turn off after 3 game ticks and turn 
 * on after 1 game tick.
 *
+* A torch that has to turn off asks the engine to wake it up again once the 
+* 3 ticks are over, rather than checking back every tick.
+*
 */
 
 #ifndef REDSTONE_COMPONENTS_REDSTONETORCH_H
@@ -33,11 +36,18 @@ namespace Redstone
 	* This class is a component that represents a Minecraft Redstone torch.
 	*
 	*/
-	class RedstoneTorch : public Component
+	class RedstoneTorch final : public Component
 	{
 
 	public:
 
+		/* Constants */
+
+		/**
+		 * @brief The ID of the class, for componentCast
+		 */
+		static const Component::ID TYPE = Component::ID::REDSTONE_TORCH;
+
 
 		/* Functions */
 
@@ -49,10 +59,8 @@ namespace Redstone
 		 * @param init	The initial state of the torch (true for on)
 		 */
 		RedstoneTorch( bool init = true ) :
-			_isOn(init), _direction(Map::Direction::DOWN), _oldTickNumber(-1)
-		{
-			this->_prevStates[0] = this->_prevStates[1] = this->_prevStates[2] = init;
-		}
+			_isOn(init), _direction(Map::Direction::DOWN), _offTick(-1)
+		{}
 
 		/**
 		* @brief Need this to clone the component
@@ -63,6 +71,25 @@ namespace Redstone
 			return new RedstoneTorch(*this);
 		}
 
+		/**
+		* @brief Clone the component into some memory
+		* @param memory	getSize() bytes to build the clone in
+		* @returns The clone
+		*/
+		RedstoneTorch * cloneAt(void * memory) const
+		{
+			return new (memory) RedstoneTorch(*this);
+		}
+
+		/**
+		* @brief Get the number of bytes cloneAt needs
+		* @returns The size of the class
+		*/
+		size_t getSize() const
+		{
+			return sizeof(RedstoneTorch);
+		}
+
 		/**
 		* @brief Update the component
 		* @brief engine	The engine being used
@@ -76,7 +103,7 @@ namespace Redstone
 		*/
 		virtual Component::ID getId() const
 		{
-			return Component::ID::REDSTONE_TORCH;
+			return TYPE;
 		}
 
 		/**
@@ -86,6 +113,74 @@ namespace Redstone
 		*/
 		bool operator==(const Component & b) const;
 
+		/**
+		* @brief Get whether the component gives off power or changes by itself
+		* @returns true, since it does
+		*/
+		bool isActive() const
+		{
+			return true;
+		}
+
+		/**
+		* @brief Get whether a change in a neighbour can change us
+		* @param neighbor	The component next to us
+		* @param direction	The direction from the neighbour towards us
+		* @returns true if it may change our state
+		*/
+		bool isSensitiveTo(
+			const Component & neighbor,
+			const Map::Direction & direction) const;
+
+		/**
+		* @brief Get a number that sums up the state of the component
+		*
+		* How long is left to wait is kept by the engine, in the update it
+		* has scheduled for us.
+		*
+		* @returns Whether it is on, whether it is waiting, and its direction
+		*/
+		unsigned getStateKey() const
+		{
+			return (this->_isOn ? 1 : 0) | (this->_offTick != -1 ? 2 : 0)
+				| (static_cast<unsigned>(this->_direction) << 2);
+		}
+
+		/**
+		* @brief Set the state from a key made by getStateKey
+		*
+		* The wake-up of a waiting torch belongs to the engine it was in, so
+		* the torch comes back as not waiting.
+		*
+		* @note For initialization only, please.
+		* @param key	The state key
+		*/
+		void setStateKey(unsigned key)
+		{
+			this->_isOn = (key & 1) != 0;
+			this->_direction = static_cast<Map::Direction>((key >> 2) & 7);
+			this->_offTick = -1;
+		}
+
+		/**
+		* @brief Get a number that sums up what can be seen of the component
+		* @returns Whether it is on
+		*/
+		unsigned getVisibleState() const
+		{
+			return this->_isOn ? 1 : 0;
+		}
+
+		/**
+		* @brief Move the tick we may turn off at forward
+		* @param ticks	The number of ticks skipped
+		*/
+		void shiftTicks(int ticks)
+		{
+			if (this->_offTick != -1)
+				this->_offTick += ticks;
+		}
+
 		/**
 		 * @brief Set the torch direction
 		 * @param dir	The direction towards the block to which it's attached
@@ -135,10 +230,9 @@ namespace Redstone
 		/* data */
 
 		bool _isOn;
-		bool _prevStates[3];
 		Map::Direction _direction;
 
-		int _oldTickNumber;
+		int _offTick;	// Tick we may turn off at, or -1 if not waiting
 
 	};
 
@@ -24,7 +24,7 @@ void Redstone::SolidBlock::update(
 	Redstone::Engine & engine,
 	const Redstone::Map::Coordinates & coords)
 {
-	Map & map = engine.getMap();
+	Map::Cursor cursor(engine.getMap(), coords);
 
 	// We'll test against these state changes
 	bool oldStrength = this->_stronglyPowered;
@@ -38,7 +38,7 @@ void Redstone::SolidBlock::update(
 		test_coords.x += x;
 		test_coords.y += y;
 		test_coords.z += z;
-		this->_processNeighbor(map.get(test_coords), direction, test_coords);
+		this->_processNeighbor(cursor.at(x, y, z), direction, test_coords);
 	};
 
 	// Now let's do it
@@ -70,7 +70,7 @@ bool Redstone::SolidBlock::operator==(const Redstone::Component & b) const
 	if (b.getId() != this->getId())
 		return false;
 
-	auto bPtr = dynamic_cast<const SolidBlock *>(&b);
+	auto bPtr = componentCast<SolidBlock>(&b);
 	if (bPtr->getPowerLevel() != this->getPowerLevel())
 		return false;
 	if (bPtr->isStronglyPowered() != this->isStronglyPowered())
@@ -80,6 +80,36 @@ bool Redstone::SolidBlock::operator==(const Redstone::Component & b) const
 }
 
 
+/**
+ * @brief Get whether a change in a neighbour can change us
+ * @param neighbor	The component next to us
+ * @param direction	The direction from the neighbour towards us
+ * @returns true if it may change our state
+ */
+bool Redstone::SolidBlock::isSensitiveTo(
+	const Redstone::Component & neighbor,
+	const Redstone::Map::Direction & direction) const
+{
+	switch (neighbor.getId()) {
+
+	// Dust below us doesn't count
+	case Component::ID::REDSTONE_DUST:
+		return direction != Map::Direction::UP;
+
+	// Only torches below us power us
+	case Component::ID::REDSTONE_TORCH:
+		return direction == Map::Direction::UP;
+
+	// Only switches attached to us power us
+	case Component::ID::SWITCH:
+		return componentCast<Switch>(neighbor).getDirection() == direction;
+
+	default:
+		return false;
+	}
+}
+
+
 /**
  * @brief Check to see if a surrounding block will change our state
  * @param component	The component next to us
@@ -128,7 +158,7 @@ void Redstone::SolidBlock::_processNeighbor(
 void Redstone::SolidBlock::_onRedstoneDustAbove(
 	const Redstone::Component * component)
 {
-	auto dust = dynamic_cast<const RedstoneDust *>(component);
+	auto dust = componentCast<RedstoneDust>(component);
 
 	this->_powerLevel = std::max(this->_powerLevel, dust->getLevel());
 }
@@ -143,7 +173,7 @@ void Redstone::SolidBlock::_onRedstoneDustBeside(
 	const Redstone::Component * component,
 	const Redstone::Map::Direction & direction)
 {
-	auto dust = dynamic_cast<const RedstoneDust *>(component);
+	auto dust = componentCast<RedstoneDust>(component);
 
 	if (dust->hasDirection(direction))
 		this->_powerLevel = std::max(this->_powerLevel, dust->getLevel());
@@ -157,7 +187,7 @@ void Redstone::SolidBlock::_onRedstoneDustBeside(
 void Redstone::SolidBlock::_onRedstoneTorchBelow(
 	const Redstone::Component * component)
 {
-	auto torch = dynamic_cast<const RedstoneTorch *>(component);
+	auto torch = componentCast<RedstoneTorch>(component);
 
 	if (torch->isOn())
 		this->_stronglyPowered = true;
@@ -173,7 +203,7 @@ void Redstone::SolidBlock::_onSwitchBeside(
 	const Redstone::Component * component,
 	const Redstone::Map::Direction & direction)
 {
-	auto toggle = dynamic_cast<const Switch *>(component);
+	auto toggle = componentCast<Switch>(component);
 
 	if (toggle->getDirection() == direction) {
 		if (toggle->isOn())
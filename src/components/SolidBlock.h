@@ -26,11 +26,18 @@ namespace Redstone
 	* This class is a component that represents a solid Minecraft block.
 	*
 	*/
-	class SolidBlock : public Component
+	class SolidBlock final : public Component
 	{
 
 	public:
 
+		/* Constants */
+
+		/**
+		 * @brief The ID of the class, for componentCast
+		 */
+		static const Component::ID TYPE = Component::ID::SOLID_BLOCK;
+
 
 		/* Functions */
 
@@ -47,6 +54,25 @@ namespace Redstone
 			return new SolidBlock(*this);
 		}
 
+		/**
+		 * @brief Clone the component into some memory
+		 * @param memory	getSize() bytes to build the clone in
+		 * @returns The clone
+		 */
+		SolidBlock * cloneAt(void * memory) const
+		{
+			return new (memory) SolidBlock(*this);
+		}
+
+		/**
+		 * @brief Get the number of bytes cloneAt needs
+		 * @returns The size of the class
+		 */
+		size_t getSize() const
+		{
+			return sizeof(SolidBlock);
+		}
+
 		/**
 		 * @brief Update the component
 		 * @brief engine	The engine being used
@@ -60,7 +86,7 @@ namespace Redstone
 		*/
 		virtual Component::ID getId() const
 		{
-			return Component::ID::SOLID_BLOCK;
+			return TYPE;
 		}
 
 		/**
@@ -70,6 +96,45 @@ namespace Redstone
 		 */
 		bool operator==(const Component & b) const;
 
+		/**
+		 * @brief Get whether a change in a neighbour can change us
+		 * @param neighbor	The component next to us
+		 * @param direction	The direction from the neighbour towards us
+		 * @returns true if it may change our state
+		 */
+		bool isSensitiveTo(
+			const Component & neighbor,
+			const Map::Direction & direction) const;
+
+		/**
+		 * @brief Get a number that sums up the state of the component
+		 * @returns The power level and whether it is strongly powered
+		 */
+		unsigned getStateKey() const
+		{
+			return this->_powerLevel | (this->_stronglyPowered ? 0x10 : 0);
+		}
+
+		/**
+		 * @brief Set the state from a key made by getStateKey
+		 * @note For initialization only, please.
+		 * @param key	The state key
+		 */
+		void setStateKey(unsigned key)
+		{
+			this->_powerLevel = key & 0xF;
+			this->_stronglyPowered = (key & 0x10) != 0;
+		}
+
+		/**
+		 * @brief Get a number that sums up what can be seen of the component
+		 * @returns The power level and whether it is strongly powered
+		 */
+		unsigned getVisibleState() const
+		{
+			return this->getStateKey();
+		}
+
 		/**
 		 * @brief Get whether it is strongly powered
 		 * @returns true if it is strongly powered
@@ -38,7 +38,7 @@ bool Redstone::Switch::operator==(const Redstone::Component & b) const
 	if (b.getId() != this->getId())
 		return false;
 
-	auto bPtr = dynamic_cast<const Switch *>(&b);
+	auto bPtr = componentCast<Switch>(&b);
 	if (bPtr->isOn() != this->isOn())
 		return false;
 	if (bPtr->getDirection() != this->getDirection())
@@ -25,11 +25,18 @@ namespace Redstone
 	* This class is a component that represents a Minecraft switch.
 	*
 	*/
-	class Switch : public Component
+	class Switch final : public Component
 	{
 
 	public:
 
+		/* Constants */
+
+		/**
+		 * @brief The ID of the class, for componentCast
+		 */
+		static const Component::ID TYPE = Component::ID::SWITCH;
+
 
 		/* Functions */
 
@@ -46,6 +53,25 @@ namespace Redstone
 			return new Switch(*this);
 		}
 
+		/**
+		* @brief Clone the component into some memory
+		* @param memory	getSize() bytes to build the clone in
+		* @returns The clone
+		*/
+		Switch * cloneAt(void * memory) const
+		{
+			return new (memory) Switch(*this);
+		}
+
+		/**
+		* @brief Get the number of bytes cloneAt needs
+		* @returns The size of the class
+		*/
+		size_t getSize() const
+		{
+			return sizeof(Switch);
+		}
+
 		/**
 		* @brief Update the component
 		* @brief engine	The engine being used
@@ -59,7 +85,7 @@ namespace Redstone
 		*/
 		virtual Component::ID getId() const
 		{
-			return Component::ID::SWITCH;
+			return TYPE;
 		}
 
 		/**
@@ -69,6 +95,44 @@ namespace Redstone
 		*/
 		bool operator==(const Component & b) const;
 
+		/**
+		* @brief Get whether the component gives off power or changes by itself
+		* @returns true, since it does
+		*/
+		bool isActive() const
+		{
+			return true;
+		}
+
+		/**
+		* @brief Get a number that sums up the state of the component
+		* @returns Whether it is on and its direction
+		*/
+		unsigned getStateKey() const
+		{
+			return (this->_isOn ? 1 : 0) | (static_cast<unsigned>(this->_direction) << 1);
+		}
+
+		/**
+		* @brief Set the state from a key made by getStateKey
+		* @note For initialization only, please.
+		* @param key	The state key
+		*/
+		void setStateKey(unsigned key)
+		{
+			this->_isOn = (key & 1) != 0;
+			this->_direction = static_cast<Map::Direction>((key >> 1) & 7);
+		}
+
+		/**
+		* @brief Get a number that sums up what can be seen of the component
+		* @returns Whether it is on
+		*/
+		unsigned getVisibleState() const
+		{
+			return this->_isOn ? 1 : 0;
+		}
+
 		/**
 		* @brief Set the switch direction
 		* @param dir	The direction towards the block to which it's attached
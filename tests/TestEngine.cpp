@@ -44,6 +44,55 @@ void outputTest(const char * lbl, const T & expected, const T & value)
 }
 
 
+/**
+ * @brief A component that asks to be woken up over and over
+ *
+ * Nothing built in asks for the same location twice, so this stands in for
+ * one that does.  It borrows an ID that no other component uses yet.
+ *
+ */
+class ImpatientComponent : public Redstone::Component
+{
+
+public:
+
+	int updates = 0;
+
+	Redstone::Component * clone() const
+	{
+		return new ImpatientComponent(*this);
+	}
+
+	void update(Redstone::Engine & engine, const Redstone::Map::Coordinates & coords)
+	{
+		++this->updates;
+		if (engine.getTickNumber() != 0)
+			return;
+
+		// The first wins, then gets moved up by the second
+		this->scheduleUpdate(engine, coords, 5);
+		this->markNextUpdate(engine, coords);
+		this->markNextUpdate(engine, coords);
+		this->scheduleUpdate(engine, coords, 3);
+	}
+
+	Redstone::Component::ID getId() const
+	{
+		return Redstone::Component::ID::STONE_BUTTON;
+	}
+
+	bool operator==(const Redstone::Component & b) const
+	{
+		return &b == this;
+	}
+
+	bool isActive() const
+	{
+		return true;
+	}
+};
+
+
 /**
  * @brief Test empty maps in the engine
  *
@@ -245,8 +294,9 @@ void testActiveMap2()
 		engine.getMap().get(Redstone::Map::Coordinates(2, 1, 0))
 		)->flip();
 
-	// Test to make sure it's not still
-	outputTest("engine.isStill()", (1 == 0), engine.isStill());
+	// The switches point north, off the map, so nothing is attached to them
+	// and nothing has to be updated
+	outputTest("engine.isStill()", (1 == 1), engine.isStill());
 
 	// Run it for 4 ticks
 	outputTest("engine.run() for 4 ticks", "n/a", "n/a");
@@ -271,6 +321,732 @@ void testActiveMap2()
 }
 
 
+/**
+ * @brief Test that duplicate updates are dropped
+ *
+ * A long wire asks its neighbours to update over and over again while it
+ * powers up.  Each location should only be waiting in the queue once.
+ *
+ */
+void testDuplicateUpdates()
+{
+	Redstone::Map map(17, 2, 1);
+
+	Redstone::SolidBlock * solid = new Redstone::SolidBlock();
+	Redstone::RedstoneDust * dust = new Redstone::RedstoneDust();
+
+	// Construct the map (a wire powered from one end)
+	for (int x = 0; x != 17; ++x) {
+		map.set(Redstone::Map::Coordinates(x, 0, 0), solid->clone());
+		map.set(Redstone::Map::Coordinates(x, 1, 0), dust->clone());
+	}
+	map.set(Redstone::Map::Coordinates(0, 1, 0), new Redstone::RedstoneBlock());
+
+	// Now set it in the engine
+	outputTest("engine.setMap(map); with a 16 long wire", "n/a", "n/a");
+	Redstone::Engine engine;
+	engine.setMap(map);
+
+	// Each dust, the block under it, and the redstone block are asked for
+	// more than once, but should only have been queued once
+	outputTest("engine.getSetupUpdates()", (size_t)33, engine.getSetupUpdates());
+
+	// A 16 long wire runs out of power at the far end
+	auto end = dynamic_cast<const Redstone::RedstoneDust *>(
+		engine.getMap().get(Redstone::Map::Coordinates(16, 1, 0)));
+	outputTest("end of wire level", 0, end->getLevel());
+	auto beforeEnd = dynamic_cast<const Redstone::RedstoneDust *>(
+		engine.getMap().get(Redstone::Map::Coordinates(15, 1, 0)));
+	outputTest("next to end of wire level", 1, beforeEnd->getLevel());
+
+	// A cube of switches, which never change, so each is updated once
+	Redstone::Map cube(3, 3, 3);
+	for (int x = 0; x != 3; ++x)
+		for (int y = 0; y != 3; ++y)
+			for (int z = 0; z != 3; ++z)
+				cube.set(Redstone::Map::Coordinates(x, y, z), new Redstone::Switch());
+
+	outputTest("engine.setMap(cube); with 27 switches", "n/a", "n/a");
+	engine.setMap(cube);
+
+	// Each is asked for itself and by each of its neighbours (54 pairs)
+	outputTest("engine.getTotalStats().totalUpdates()", 27ull,
+		engine.getTotalStats().totalUpdates());
+	outputTest("engine.getSuppressedUpdates()", 108ull, engine.getSuppressedUpdates());
+
+	// Asking for a later tick again only keeps the earliest wake
+	Redstone::Map single(1, 1, 1);
+	single.set(Redstone::Map::Coordinates(0, 0, 0), new ImpatientComponent());
+
+	outputTest("engine.setMap(single); with a component that asks 4 times", "n/a", "n/a");
+	engine.setMap(single);
+	auto impatient = dynamic_cast<const ImpatientComponent *>(
+		engine.getMap().get(Redstone::Map::Coordinates(0, 0, 0)));
+	outputTest("engine.getSuppressedUpdates()", 3ull, engine.getSuppressedUpdates());
+	outputTest("engine.getTotalStats().laterUpdates", 2ull,
+		engine.getTotalStats().laterUpdates);
+
+	engine.run();
+	outputTest("updates after 1 tick", 2, impatient->updates);
+	outputTest("engine.isStill()", (1 == 1), engine.isStill());
+	engine.runTicks(10);
+	outputTest("updates after 11 ticks", 2, impatient->updates);
+
+	// Clean up
+	delete solid;
+	delete dust;
+}
+
+
+/**
+ * @brief Test the redstone torch delays
+ *
+ * Torches should turn off 3 ticks after they are powered, and they should
+ * turn back on right away.  They wait without updating every tick.
+ *
+ */
+void testTorchDelay()
+{
+	Redstone::Map map(2, 3, 1);
+
+	Redstone::Switch * toggle = new Redstone::Switch();
+	toggle->setDirection(Redstone::Map::Direction::EAST);
+
+	// Construct the map (a switch on a block with a torch on top)
+	map.set(Redstone::Map::Coordinates(0, 1, 0), toggle);
+	map.set(Redstone::Map::Coordinates(1, 1, 0), new Redstone::SolidBlock());
+	map.set(Redstone::Map::Coordinates(1, 2, 0), new Redstone::RedstoneTorch());
+
+	// Now set it in the engine
+	outputTest("engine.setMap(map); with a torch on a block", "n/a", "n/a");
+	Redstone::Engine engine;
+	engine.setMap(map);
+	outputTest("engine.isStill()", (1 == 1), engine.isStill());
+
+	auto torch = dynamic_cast<const Redstone::RedstoneTorch *>(
+		engine.getMap().get(Redstone::Map::Coordinates(1, 2, 0)));
+
+	// Flip the switch, and it should take 3 more ticks to turn off
+	outputTest("flip switch", "n/a", "n/a");
+	dynamic_cast<Redstone::Switch *>(
+		engine.getMap().get(Redstone::Map::Coordinates(0, 1, 0))
+		)->flip();
+
+	engine.run();
+	outputTest("torch after 1 tick (on)", (1 == 1), torch->isOn());
+	engine.run();
+	engine.run();
+	outputTest("torch after 3 ticks (on)", (1 == 1), torch->isOn());
+	engine.run();
+	outputTest("torch after 4 ticks (off)", (1 == 0), torch->isOn());
+	outputTest("engine.isStill()", (1 == 1), engine.isStill());
+
+	// Flip it back, and it should turn on in the next tick
+	outputTest("flip switch", "n/a", "n/a");
+	dynamic_cast<Redstone::Switch *>(
+		engine.getMap().get(Redstone::Map::Coordinates(0, 1, 0))
+		)->flip();
+
+	engine.run();
+	outputTest("torch after 1 tick (on)", (1 == 1), torch->isOn());
+
+	// Copy a torch that is waiting to turn off into another engine, which
+	// has no wake-up for it
+	Redstone::Map powered(1, 2, 1);
+	powered.set(Redstone::Map::Coordinates(0, 0, 0), Redstone::RedstoneBlock::shared());
+	powered.set(Redstone::Map::Coordinates(0, 1, 0), new Redstone::RedstoneTorch());
+
+	outputTest("copy a waiting torch into another engine", "n/a", "n/a");
+	Redstone::Engine first;
+	first.setMap(powered);
+	Redstone::Engine second;
+	second.setMap(first.getMap());
+	outputTest("second.isStill()", (1 == 0), second.isStill());
+
+	second.runTicks(10);
+	auto copied = dynamic_cast<const Redstone::RedstoneTorch *>(
+		second.getMap().get(Redstone::Map::Coordinates(0, 1, 0)));
+	outputTest("torch after 10 ticks (off)", (1 == 0), copied->isOn());
+	outputTest("second.isStill()", (1 == 1), second.isStill());
+}
+
+
+/**
+ * @brief Test growing the map while updates are waiting
+ *
+ * The engine keeps waiting locations by map index, and growing the map
+ * changes the index of every location.
+ *
+ */
+void testMapGrowth()
+{
+	Redstone::Map map(2, 3, 1);
+
+	Redstone::Switch * toggle = new Redstone::Switch();
+	toggle->setDirection(Redstone::Map::Direction::EAST);
+
+	// Construct the map (a switch on a block with a torch on top)
+	map.set(Redstone::Map::Coordinates(0, 1, 0), toggle);
+	map.set(Redstone::Map::Coordinates(1, 1, 0), new Redstone::SolidBlock());
+	map.set(Redstone::Map::Coordinates(1, 2, 0), new Redstone::RedstoneTorch());
+
+	Redstone::Engine engine;
+	engine.setMap(map);
+	engine.setChangeTracking(true);
+
+	auto torch = dynamic_cast<const Redstone::RedstoneTorch *>(
+		engine.getMap().get(Redstone::Map::Coordinates(1, 2, 0)));
+
+	// Flip the switch, and grow the map while the torch is waiting
+	outputTest("flip switch, run 1 tick, and grow to x = 10", "n/a", "n/a");
+	dynamic_cast<Redstone::Switch *>(
+		engine.getMap().get(Redstone::Map::Coordinates(0, 1, 0))
+		)->flip();
+	engine.run();
+	engine.clearChanges();
+	engine.getMap().set(Redstone::Map::Coordinates(10, 0, 0), Redstone::GlassBlock::shared());
+
+	engine.runTicks(10);
+	outputTest("torch after 10 more ticks (off)", (1 == 0), torch->isOn());
+	outputTest("engine.isStill()", (1 == 1), engine.isStill());
+	outputTest("engine.getChanges().size()", (size_t)1, engine.getChanges().size());
+	if (!engine.getChanges().empty()) {
+		Redstone::Map::Coordinates changed = engine.getMap().coordinates(engine.getChanges()[0]);
+		outputTest("changed x", 1, changed.x);
+		outputTest("changed y", 2, changed.y);
+	}
+
+	// Flip it back, and grow the other way before the update is run
+	outputTest("flip switch, and grow to y = -5", "n/a", "n/a");
+	dynamic_cast<Redstone::Switch *>(
+		engine.getMap().get(Redstone::Map::Coordinates(0, 1, 0))
+		)->flip();
+	engine.getMap().set(Redstone::Map::Coordinates(0, -5, 0), Redstone::GlassBlock::shared());
+
+	engine.run();
+	outputTest("torch after 1 tick (on)", (1 == 1), torch->isOn());
+}
+
+
+/**
+ * @brief Test running many ticks at once
+ *
+ * A still map should be skipped over without running any ticks, and a
+ * busy one should stop as soon as it is still.
+ *
+ */
+void testRunTicks()
+{
+	Redstone::Map map(2, 3, 1);
+
+	Redstone::Switch * toggle = new Redstone::Switch();
+	toggle->setDirection(Redstone::Map::Direction::EAST);
+
+	// Construct the map (a switch on a block with a torch on top)
+	map.set(Redstone::Map::Coordinates(0, 1, 0), toggle);
+	map.set(Redstone::Map::Coordinates(1, 1, 0), new Redstone::SolidBlock());
+	map.set(Redstone::Map::Coordinates(1, 2, 0), new Redstone::RedstoneTorch());
+
+	Redstone::Engine engine;
+	engine.setMap(map);
+
+	// Nothing to do, so the whole stretch is skipped
+	Redstone::Engine::RunStats stats = engine.runTicks(1000000);
+	outputTest("engine.runTicks(1000000) ticks", 1000000, stats.ticks);
+	outputTest("engine.runTicks(1000000) simulated ticks", 0, stats.simulatedTicks);
+	outputTest("engine.getTickNumber()", 1000001, engine.getTickNumber());
+
+	// Nothing to do, so it stops right away
+	stats = engine.runUntilStill(100);
+	outputTest("engine.runUntilStill(100) on still map", 0, stats.ticks);
+
+	// Flip the switch, and the torch turns off after the delay
+	dynamic_cast<Redstone::Switch *>(
+		engine.getMap().get(Redstone::Map::Coordinates(0, 1, 0))
+		)->flip();
+	stats = engine.runUntilStill(100);
+	outputTest("engine.runUntilStill(100) ticks", 4, stats.ticks);
+	outputTest("engine.runUntilStill(100) simulated ticks", 2, stats.simulatedTicks);
+	outputTest("engine.isStill()", (1 == 1), engine.isStill());
+
+	auto torch = dynamic_cast<const Redstone::RedstoneTorch *>(
+		engine.getMap().get(Redstone::Map::Coordinates(1, 2, 0)));
+	outputTest("torch (off)", (1 == 0), torch->isOn());
+}
+
+
+/**
+ * @brief Test finding and skipping over repeated cycles
+ *
+ * A torch that powers its own block through some dust never settles down.
+ * The engine should find the cycle, and jumping over it should end up in
+ * the same place as running every tick.
+ *
+ */
+void testFastForward()
+{
+	Redstone::Map map(3, 3, 1);
+
+	Redstone::RedstoneTorch * torch = new Redstone::RedstoneTorch();
+	torch->setDirection(Redstone::Map::Direction::WEST);
+
+	// Construct the map (a torch on the side of a block, with dust looping
+	// back from above the torch to the top of the block)
+	map.set(Redstone::Map::Coordinates(1, 1, 0), new Redstone::SolidBlock());
+	map.set(Redstone::Map::Coordinates(2, 1, 0), torch);
+	map.set(Redstone::Map::Coordinates(1, 2, 0), new Redstone::RedstoneDust());
+	map.set(Redstone::Map::Coordinates(2, 2, 0), new Redstone::RedstoneDust());
+
+	// Run one engine the long way, and one the short way
+	Redstone::Engine slow, fast;
+	slow.setMap(map);
+	fast.setMap(map);
+
+	slow.runTicks(100000);
+	Redstone::Engine::RunStats stats = fast.fastForward(100000);
+
+	outputTest("fast.getPeriod()", 3, fast.getPeriod());
+	outputTest("fast.fastForward(100000) ticks", 100000, stats.ticks);
+	outputTest("fast.fastForward(100000) simulated ticks < 20", (1 == 1),
+		stats.simulatedTicks < 20);
+	outputTest("fast.getTickNumber()", slow.getTickNumber(), fast.getTickNumber());
+
+	// They should stay together from here on
+	slow.runTicks(10);
+	fast.runTicks(10);
+
+	bool same = true;
+	Redstone::Map::Coordinates coords;
+	for (coords.x = 0; coords.x != 3; ++coords.x) {
+		for (coords.y = 0; coords.y != 3; ++coords.y) {
+			auto a = slow.getMap().get(coords);
+			auto b = fast.getMap().get(coords);
+			if (a && b && !(*a == *b))
+				same = false;
+		}
+	}
+	outputTest("maps match", (1 == 1), same);
+
+	// Cycle detection was only on for the fast forward, so a still map is
+	// skipped over again
+	Redstone::Map still(2, 3, 1);
+	still.set(Redstone::Map::Coordinates(1, 1, 0), new Redstone::SolidBlock());
+	still.set(Redstone::Map::Coordinates(1, 2, 0), new Redstone::RedstoneTorch());
+
+	fast.setMap(still);
+	fast.fastForward(10);
+	stats = fast.runTicks(1000);
+	outputTest("fast.runTicks(1000) after fastForward, simulated ticks", 0, stats.simulatedTicks);
+}
+
+
+/**
+ * @brief Test that setting a map only updates what can change
+ *
+ * A big slab of solid blocks with a short wire on it should only start
+ * off updating the wire and the blocks around it.
+ *
+ */
+void testSparseSetup()
+{
+	Redstone::Map map(64, 2, 64);
+
+	Redstone::SolidBlock * solid = new Redstone::SolidBlock();
+	Redstone::RedstoneDust * dust = new Redstone::RedstoneDust();
+
+	// Construct the map (a floor with a 4 long wire powered from one end)
+	for (int x = 0; x != 64; ++x) {
+		for (int z = 0; z != 64; ++z)
+			map.set(Redstone::Map::Coordinates(x, 0, z), solid->clone());
+	}
+	map.set(Redstone::Map::Coordinates(0, 1, 0), new Redstone::RedstoneBlock());
+	for (int x = 1; x != 5; ++x)
+		map.set(Redstone::Map::Coordinates(x, 1, 0), dust->clone());
+
+	// Now set it in the engine
+	outputTest("engine.setMap(map); with a wire on a 64x64 floor", "n/a", "n/a");
+	Redstone::Engine engine;
+	engine.setMap(map);
+
+	// The wire, the blocks under it, and the redstone block next to it
+	outputTest("engine.getSetupUpdates()", (size_t)9, engine.getSetupUpdates());
+
+	auto end = dynamic_cast<const Redstone::RedstoneDust *>(
+		engine.getMap().get(Redstone::Map::Coordinates(4, 1, 0)));
+	engine.runUntilStill(100);
+	outputTest("end of wire level", 12, end->getLevel());
+
+	// Clean up
+	delete solid;
+	delete dust;
+}
+
+
+/**
+ * @brief Test that only sensitive neighbours are updated
+ *
+ * A switch surrounded by glass, except for the block it's attached to,
+ * should only cause that block to update when it is flipped.
+ *
+ */
+void testSensitivity()
+{
+	Redstone::Map map(3, 3, 3);
+
+	Redstone::GlassBlock * glass = new Redstone::GlassBlock();
+	Redstone::Switch * toggle = new Redstone::Switch();
+	toggle->setDirection(Redstone::Map::Direction::EAST);
+
+	// Construct the map (glass all around a switch on the side of a block)
+	for (int x = 0; x != 3; ++x) {
+		for (int y = 0; y != 3; ++y) {
+			for (int z = 0; z != 3; ++z)
+				map.set(Redstone::Map::Coordinates(x, y, z), glass->clone());
+		}
+	}
+	map.set(Redstone::Map::Coordinates(1, 1, 1), toggle);
+	map.set(Redstone::Map::Coordinates(2, 1, 1), new Redstone::SolidBlock());
+
+	Redstone::Engine engine;
+	engine.setMap(map);
+
+	// Flip the switch
+	dynamic_cast<Redstone::Switch *>(
+		engine.getMap().get(Redstone::Map::Coordinates(1, 1, 1))
+		)->flip();
+	Redstone::Engine::RunStats stats = engine.runUntilStill(10);
+	outputTest("updates after flipping switch", 1ull, stats.updates);
+
+	auto solid = dynamic_cast<const Redstone::SolidBlock *>(
+		engine.getMap().get(Redstone::Map::Coordinates(2, 1, 1)));
+	outputTest("block is strongly powered", (1 == 1), solid->isStronglyPowered());
+
+	// The direction is from the neighbour towards the one asked, so
+	// something below comes from UP
+	Redstone::SolidBlock block;
+	Redstone::RedstoneDust dust;
+	Redstone::RedstoneTorch torch;
+	outputTest("block.isSensitiveTo(dust, DOWN) (dust on top)", (1 == 1),
+		block.isSensitiveTo(dust, Redstone::Map::Direction::DOWN));
+	outputTest("block.isSensitiveTo(dust, UP) (dust below)", (1 == 0),
+		block.isSensitiveTo(dust, Redstone::Map::Direction::UP));
+	outputTest("block.isSensitiveTo(torch, UP) (torch below)", (1 == 1),
+		block.isSensitiveTo(torch, Redstone::Map::Direction::UP));
+	outputTest("block.isSensitiveTo(torch, DOWN) (torch on top)", (1 == 0),
+		block.isSensitiveTo(torch, Redstone::Map::Direction::DOWN));
+	outputTest("torch.isSensitiveTo(block, UP) (block below)", (1 == 1),
+		torch.isSensitiveTo(block, Redstone::Map::Direction::UP));
+	outputTest("torch.isSensitiveTo(block, DOWN) (block on top)", (1 == 0),
+		torch.isSensitiveTo(block, Redstone::Map::Direction::DOWN));
+
+	// Clean up
+	delete glass;
+}
+
+
+/**
+ * @brief Test running a tick a few updates at a time
+ *
+ * Breaking a tick up should give the same results as running it all at
+ * once, and the tick number shouldn't move until it's done.
+ *
+ */
+void testPartialTicks()
+{
+	Redstone::Map map(17, 2, 1);
+
+	Redstone::SolidBlock * solid = new Redstone::SolidBlock();
+	Redstone::RedstoneDust * dust = new Redstone::RedstoneDust();
+
+	// Construct the map (a wire with a switch at one end)
+	for (int x = 0; x != 17; ++x) {
+		map.set(Redstone::Map::Coordinates(x, 0, 0), solid->clone());
+		map.set(Redstone::Map::Coordinates(x, 1, 0), dust->clone());
+	}
+	map.set(Redstone::Map::Coordinates(0, 1, 0), new Redstone::Switch());
+
+	Redstone::Engine whole, parts;
+	whole.setMap(map);
+	parts.setMap(map);
+
+	// Flip both switches
+	dynamic_cast<Redstone::Switch *>(
+		whole.getMap().get(Redstone::Map::Coordinates(0, 1, 0))
+		)->flip();
+	dynamic_cast<Redstone::Switch *>(
+		parts.getMap().get(Redstone::Map::Coordinates(0, 1, 0))
+		)->flip();
+
+	// Run one all at once, and the other 3 updates at a time
+	int tick = parts.getTickNumber();
+	whole.run();
+
+	int calls = 1;
+	bool sameTick = true;
+	while (!parts.runUpdates(3)) {
+		++calls;
+		if (parts.getTickNumber() != tick)
+			sameTick = false;
+	}
+	outputTest("parts.runUpdates(3) took more than one call", (1 == 1), calls > 1);
+	outputTest("tick number held until done", (1 == 1), sameTick);
+	outputTest("parts.getTickNumber()", whole.getTickNumber(), parts.getTickNumber());
+
+	bool same = true;
+	for (int x = 0; x != 17; ++x) {
+		Redstone::Map::Coordinates coords(x, 1, 0);
+		if (!(*whole.getMap().get(coords) == *parts.getMap().get(coords)))
+			same = false;
+	}
+	outputTest("maps match", (1 == 1), same);
+
+	// Clean up
+	delete solid;
+	delete dust;
+}
+
+
+/**
+ * @brief Test the list of changed locations
+ *
+ * Powering a short wire should list each piece of dust and the blocks
+ * under them and the switch once, and nothing else.
+ *
+ */
+void testChanges()
+{
+	Redstone::Map map(5, 2, 1);
+
+	Redstone::SolidBlock * solid = new Redstone::SolidBlock();
+	Redstone::RedstoneDust * dust = new Redstone::RedstoneDust();
+
+	// Construct the map (a wire with a switch at one end)
+	for (int x = 0; x != 5; ++x) {
+		map.set(Redstone::Map::Coordinates(x, 0, 0), solid->clone());
+		map.set(Redstone::Map::Coordinates(x, 1, 0), dust->clone());
+	}
+	map.set(Redstone::Map::Coordinates(0, 1, 0), new Redstone::Switch());
+
+	Redstone::Engine engine;
+	engine.setMap(map);
+	engine.setChangeTracking(true);
+
+	// Nothing happens, so nothing changes
+	engine.run();
+	outputTest("engine.getChanges().size() when still", (size_t)0, engine.getChanges().size());
+
+	// Flip the switch
+	dynamic_cast<Redstone::Switch *>(
+		engine.getMap().get(Redstone::Map::Coordinates(0, 1, 0))
+		)->flip();
+	engine.runUntilStill(10);
+
+	bool allDust = true;
+	int dustCount = 0;
+	for (auto index : engine.getChanges()) {
+		auto coords = engine.getMap().coordinates(index);
+		if (coords.y == 1)
+			++dustCount;
+		else if (coords.y != 0)
+			allDust = false;
+	}
+	outputTest("dust listed", 4, dustCount);
+	outputTest("only dust and blocks listed", (1 == 1), allDust);
+	outputTest("engine.getChanges().size()", (size_t)9, engine.getChanges().size());
+
+	engine.clearChanges();
+	outputTest("engine.getChanges().size() after clear", (size_t)0, engine.getChanges().size());
+
+	// Clean up
+	delete solid;
+	delete dust;
+}
+
+
+/**
+ * @brief Test that a whole wire is worked out at once
+ *
+ * Turning a long wire off should take each dust straight to 0, instead of
+ * letting the dust keep each other up and count down.
+ *
+ */
+void testWholeWire()
+{
+	const int LENGTH = 16;
+	Redstone::Map map(LENGTH, 2, 1);
+
+	// Construct the map (a long wire with a switch at one end)
+	for (int x = 0; x != LENGTH; ++x) {
+		map.set(Redstone::Map::Coordinates(x, 0, 0), new Redstone::SolidBlock());
+		map.set(Redstone::Map::Coordinates(x, 1, 0), new Redstone::RedstoneDust());
+	}
+	map.set(Redstone::Map::Coordinates(0, 1, 0), new Redstone::Switch());
+
+	Redstone::Engine engine;
+	engine.setMap(map);
+	auto level = [&engine](int x) {
+		return dynamic_cast<const Redstone::RedstoneDust *>(
+			engine.getMap().get(Redstone::Map::Coordinates(x, 1, 0)))->getLevel();
+	};
+	auto flip = [&engine]() {
+		dynamic_cast<Redstone::Switch *>(
+			engine.getMap().get(Redstone::Map::Coordinates(0, 1, 0))
+			)->flip();
+	};
+
+	// Turn it on
+	flip();
+	engine.runUntilStill(10);
+	outputTest("level at 1 when on", 15, level(1));
+	outputTest("level at 15 when on", 1, level(LENGTH - 1));
+
+	// And off again, with every dust changing once
+	engine.setChangeTracking(true);
+	engine.resetStats();
+	flip();
+	engine.runUntilStill(10);
+	outputTest("level at 1 when off", 0, level(1));
+	outputTest("level at 15 when off", 0, level(LENGTH - 1));
+
+	int dustChanges = 0;
+	for (auto index : engine.getChanges()) {
+		if (engine.getMap().coordinates(index).y == 1)
+			++dustChanges;
+	}
+	outputTest("dust listed", LENGTH - 1, dustChanges);
+	outputTest("dust updates no more than twice the wire", (1 == 1),
+		engine.getTotalStats().updates[static_cast<int>(Redstone::Component::ID::REDSTONE_DUST)]
+			<= 2ull * LENGTH);
+}
+
+
+/**
+ * @brief Test that wires kept between updates are found again after an edit
+ *
+ * Two wires are run, and one of them is cut.  The cut one should only
+ * carry power up to the gap, and the other one should carry on as before.
+ *
+ */
+void testDustGraph()
+{
+	const int LENGTH = 16;
+	Redstone::Map map(LENGTH, 2, 3);
+
+	// Construct the map (two long wires, each with a switch at one end)
+	for (int z = 0; z <= 2; z += 2) {
+		for (int x = 0; x != LENGTH; ++x) {
+			map.set(Redstone::Map::Coordinates(x, 0, z), new Redstone::SolidBlock());
+			map.set(Redstone::Map::Coordinates(x, 1, z), new Redstone::RedstoneDust());
+		}
+		map.set(Redstone::Map::Coordinates(0, 1, z), new Redstone::Switch());
+	}
+
+	Redstone::Engine engine;
+	engine.setMap(map);
+	auto level = [&engine](int x, int z) {
+		return dynamic_cast<const Redstone::RedstoneDust *>(
+			engine.getMap().get(Redstone::Map::Coordinates(x, 1, z)))->getLevel();
+	};
+	auto flip = [&engine](int z) {
+		dynamic_cast<Redstone::Switch *>(
+			engine.getMap().get(Redstone::Map::Coordinates(0, 1, z))
+			)->flip();
+		engine.runUntilStill(10);
+	};
+
+	// Run both wires on and off, so they are kept
+	flip(0);
+	flip(2);
+	flip(0);
+	outputTest("wires kept", (1 == 1), engine.memoryUsage().dustGraph > 0);
+	outputTest("level at 15 when on", 1, level(LENGTH - 1, 2));
+
+	// Cut the first wire, and turn it back on
+	engine.getMap().set(Redstone::Map::Coordinates(8, 1, 0), nullptr);
+	flip(0);
+	outputTest("level before the cut", 9, level(7, 0));
+	outputTest("level after the cut", 0, level(9, 0));
+	outputTest("level at 15 of the other wire", 1, level(LENGTH - 1, 2));
+
+	// The other wire still works
+	flip(2);
+	outputTest("level at 1 of the other wire when off", 0, level(1, 2));
+	outputTest("level at 15 of the other wire when off", 0, level(LENGTH - 1, 2));
+}
+
+
+/**
+ * @brief Test the engine's counters
+ *
+ * Turning a torch off should count the updates of each component, the
+ * wake-up the torch asks for, and the updates that changed nothing.
+ *
+ */
+void testStats()
+{
+	Redstone::Map map(2, 3, 1);
+
+	Redstone::Switch * toggle = new Redstone::Switch();
+	toggle->setDirection(Redstone::Map::Direction::EAST);
+
+	// Construct the map (a switch on a block with a torch on top)
+	map.set(Redstone::Map::Coordinates(0, 1, 0), toggle);
+	map.set(Redstone::Map::Coordinates(1, 1, 0), new Redstone::SolidBlock());
+	map.set(Redstone::Map::Coordinates(1, 2, 0), new Redstone::RedstoneTorch());
+
+	Redstone::Engine engine;
+	engine.setMap(map);
+	engine.resetStats();
+
+	// Flip the switch, and let the torch turn off
+	dynamic_cast<Redstone::Switch *>(
+		engine.getMap().get(Redstone::Map::Coordinates(0, 1, 0))
+		)->flip();
+	Redstone::Engine::RunStats run = engine.runUntilStill(10);
+
+	const Redstone::Engine::Stats & stats = engine.getTotalStats();
+	outputTest("stats.totalUpdates()", run.updates, stats.totalUpdates());
+	outputTest("solid block updates", 1ull,
+		stats.updates[static_cast<int>(Redstone::Component::ID::SOLID_BLOCK)]);
+	outputTest("torch updates", 2ull,
+		stats.updates[static_cast<int>(Redstone::Component::ID::REDSTONE_TORCH)]);
+	outputTest("stats.laterUpdates", 1ull, stats.laterUpdates);
+	outputTest("stats.noOpUpdates", 0ull, stats.noOpUpdates);
+	outputTest("stats.peakQueue", (size_t)1, stats.peakQueue);
+
+	// The last tick was the torch turning off
+	outputTest("engine.getTickStats().totalUpdates()", 1ull,
+		engine.getTickStats().totalUpdates());
+}
+
+
+/**
+ * @brief Test measuring the memory the engine holds
+ *
+ * After a torch has been run, the queues and flags have all been used,
+ * so each should own some memory, and the total should cover them all.
+ *
+ */
+void testMemoryUsage()
+{
+	Redstone::Map map(1, 2, 1);
+	map.set(Redstone::Map::Coordinates(0, 0, 0), new Redstone::SolidBlock());
+	map.set(Redstone::Map::Coordinates(0, 1, 0), new Redstone::RedstoneTorch());
+
+	Redstone::Engine engine;
+	engine.setMap(map);
+	engine.runUntilStill(10);
+
+	Redstone::Engine::MemoryUsage usage = engine.memoryUsage();
+	outputTest("usage.map.counts[REDSTONE_TORCH]", (size_t)1,
+		usage.map.counts[static_cast<int>(Redstone::Component::ID::REDSTONE_TORCH)]);
+	outputTest("usage.pending >= map volume", (1 == 1), usage.pending >= map.volume());
+	outputTest("usage.updateQueue > 0", (1 == 1), usage.updateQueue > 0);
+	outputTest("usage.total() >= parts", (1 == 1),
+		usage.total() >= usage.map.total() + usage.updateQueue + usage.pending);
+}
+
+
 /**
 * @brief Main function
 */
@@ -291,6 +1067,45 @@ int main()
 	std::cout << "--Testing active map 2..." << std::endl << std::endl;
 	testActiveMap2();
 
+	std::cout << "--Testing duplicate updates..." << std::endl << std::endl;
+	testDuplicateUpdates();
+
+	std::cout << "--Testing torch delay..." << std::endl << std::endl;
+	testTorchDelay();
+
+	std::cout << "--Testing growing the map..." << std::endl << std::endl;
+	testMapGrowth();
+
+	std::cout << "--Testing running many ticks..." << std::endl << std::endl;
+	testRunTicks();
+
+	std::cout << "--Testing fast forward..." << std::endl << std::endl;
+	testFastForward();
+
+	std::cout << "--Testing sparse setup..." << std::endl << std::endl;
+	testSparseSetup();
+
+	std::cout << "--Testing sensitivity..." << std::endl << std::endl;
+	testSensitivity();
+
+	std::cout << "--Testing partial ticks..." << std::endl << std::endl;
+	testPartialTicks();
+
+	std::cout << "--Testing change list..." << std::endl << std::endl;
+	testChanges();
+
+	std::cout << "--Testing whole wires..." << std::endl << std::endl;
+	testWholeWire();
+
+	std::cout << "--Testing kept wires..." << std::endl << std::endl;
+	testDustGraph();
+
+	std::cout << "--Testing stats..." << std::endl << std::endl;
+	testStats();
+
+	std::cout << "--Testing memory usage..." << std::endl << std::endl;
+	testMemoryUsage();
+
 	// Done
 	std::cout << "== done ==" << std::endl << std::endl;
 }
@@ -12,10 +12,19 @@
 
 #include <iostream>
 #include <iomanip>
-
-#include "..src/Map.h"
+#include <utility>
+#include <vector>
+
+#include "../src/Map.h"
+#include "../src/PackedMap.h"
+#include "../src/_bits/ComponentRegistry.h"
+#include "../src/_bits/ComponentSet.h"
+#include "../src/components/Air.h"
 #include "../src/components/SolidBlock.h"
 #include "../src/components/GlassBlock.h"
+#include "../src/components/RedstoneDust.h"
+#include "../src/components/RedstoneTorch.h"
+#include "../src/components/Switch.h"
 
 
 /**
@@ -57,6 +66,19 @@ void testBasicComponents()
 		(compA->getId() == Redstone::Component::ID::SOLID_BLOCK));
 	outputTest("compC->getId() == ID::SOLID_BLOCK", (1 == 1),
 		(compC->getId() == Redstone::Component::ID::SOLID_BLOCK));
+	outputTest("compB->getId() == GlassBlock::TYPE", (1 == 1),
+		(compB->getId() == Redstone::GlassBlock::TYPE));
+	outputTest("componentCast<SolidBlock>(compC)->getPowerLevel()", 0,
+		Redstone::componentCast<Redstone::SolidBlock>(compC)->getPowerLevel());
+
+	// Visited as their own class
+	auto isGlass = [](const auto & comp) {
+		return std::is_same<std::decay_t<decltype(comp)>, Redstone::GlassBlock>::value;
+	};
+	outputTest("KnownComponents::visit(*compB) as GlassBlock", (1 == 1),
+		Redstone::KnownComponents::visit(static_cast<const Redstone::Component &>(*compB), isGlass));
+	outputTest("KnownComponents::visit(*compA) as GlassBlock", (1 == 0),
+		Redstone::KnownComponents::visit(static_cast<const Redstone::Component &>(*compA), isGlass));
 }
 
 
@@ -166,6 +188,419 @@ void testFullMaps()
 }
 
 
+/**
+ * @brief Test packed maps
+ *
+ * Packing a map and unpacking it again should give back the same map,
+ * state and all.
+ */
+void testPackedMaps()
+{
+	Redstone::Map mapA(4, 4, 4);
+
+	Redstone::RedstoneDust * dust = new Redstone::RedstoneDust();
+	dust->setLevel(7);
+	Redstone::RedstoneTorch * torch = new Redstone::RedstoneTorch(false);
+	torch->setDirection(Redstone::Map::Direction::EAST);
+
+	outputTest("Propogate mapA", "n/a", "n/a");
+	mapA.set(Redstone::Map::Coordinates(0, 0, 0), new Redstone::SolidBlock());
+	mapA.set(Redstone::Map::Coordinates(1, 0, 0), new Redstone::GlassBlock());
+	mapA.set(Redstone::Map::Coordinates(2, 1, 3), dust);
+	mapA.set(Redstone::Map::Coordinates(3, 3, 3), torch);
+
+	Redstone::PackedMap packed(mapA);
+	outputTest("packed.volume()", (size_t)64, packed.volume());
+	outputTest("packed.has({1, 1, 1})", (1 == 0), packed.has(Redstone::Map::Coordinates(1, 1, 1)));
+	outputTest("packed.getId({2, 1, 3}) == ID::REDSTONE_DUST", (1 == 1),
+		packed.getId(Redstone::Map::Coordinates(2, 1, 3)) == Redstone::Component::ID::REDSTONE_DUST);
+
+	Redstone::Map mapB = packed.toMap();
+	bool same = true;
+	Redstone::Map::Coordinates coords;
+	for (coords.x = 0; coords.x != 4; ++coords.x) {
+		for (coords.y = 0; coords.y != 4; ++coords.y) {
+			for (coords.z = 0; coords.z != 4; ++coords.z) {
+				auto a = mapA.get(coords);
+				auto b = mapB.get(coords);
+				if ((a == nullptr) != (b == nullptr) || (a && !(*a == *b)))
+					same = false;
+			}
+		}
+	}
+	outputTest("packed.toMap() matches mapA", (1 == 1), same);
+}
+
+
+/**
+ * @brief Test sharing stateless components between voxels
+ */
+void testSharedComponents()
+{
+	Redstone::Map mapA(4, 4, 4);
+	Redstone::Map::Coordinates coords;
+	for (coords.x = 0; coords.x != 4; ++coords.x)
+		for (coords.y = 0; coords.y != 4; ++coords.y)
+			for (coords.z = 0; coords.z != 4; ++coords.z)
+				mapA.set(coords, Redstone::Air::shared());
+	mapA.set(Redstone::Map::Coordinates(1, 2, 3), Redstone::GlassBlock::shared());
+	mapA.set(Redstone::Map::Coordinates(1, 2, 3), new Redstone::SolidBlock());
+
+	Redstone::Component * owned = new Redstone::Air();
+	outputTest("Air::shared()->isShared()", (1 == 1), Redstone::Air::shared()->isShared());
+	outputTest("(new Air())->isShared()", (1 == 0), owned->isShared());
+	delete owned;
+
+	Redstone::Map mapB(mapA);
+	outputTest("mapB.get({0, 0, 0}) == Air::shared()", (1 == 1),
+		mapB.get(Redstone::Map::Coordinates(0, 0, 0)) == Redstone::Air::shared());
+	outputTest("mapB.get({1, 2, 3}) != mapA.get({1, 2, 3})", (1 == 1),
+		mapB.get(Redstone::Map::Coordinates(1, 2, 3)) != mapA.get(Redstone::Map::Coordinates(1, 2, 3)));
+
+	mapB.set(Redstone::Map::Coordinates(0, 0, 0), nullptr);
+	outputTest("mapA.get({0, 0, 0}) after mapB cleared it", (1 == 1),
+		mapA.get(Redstone::Map::Coordinates(0, 0, 0)) == Redstone::Air::shared());
+}
+
+
+/**
+ * @brief Test components made in a map's own memory
+ */
+void testMadeComponents()
+{
+	Redstone::Map mapA(4, 4, 4);
+	Redstone::Map::Coordinates coords;
+	for (coords.x = 0; coords.x != 4; ++coords.x)
+		for (coords.y = 0; coords.y != 4; ++coords.y)
+			for (coords.z = 0; coords.z != 4; ++coords.z)
+				mapA.set(coords, mapA.make<Redstone::SolidBlock>());
+	mapA.set(Redstone::Map::Coordinates(1, 2, 3), mapA.make<Redstone::RedstoneTorch>(false));
+	mapA.set(Redstone::Map::Coordinates(2, 2, 2), new Redstone::RedstoneDust());
+	mapA.set(Redstone::Map::Coordinates(3, 3, 3), nullptr);
+
+	Redstone::Map mapB(mapA);
+	auto torch = mapB.get(Redstone::Map::Coordinates(1, 2, 3));
+	outputTest("mapB.get({1, 2, 3})->getId() == ID::REDSTONE_TORCH", (1 == 1),
+		torch->getId() == Redstone::Component::ID::REDSTONE_TORCH);
+	outputTest("*mapB.get({1, 2, 3}) == *mapA.get({1, 2, 3})", (1 == 1),
+		*torch == *mapA.get(Redstone::Map::Coordinates(1, 2, 3)));
+	outputTest("mapB.get({1, 2, 3}) != mapA.get({1, 2, 3})", (1 == 1),
+		torch != mapA.get(Redstone::Map::Coordinates(1, 2, 3)));
+	outputTest("mapB.get({2, 2, 2})->getId() == ID::REDSTONE_DUST", (1 == 1),
+		mapB.get(Redstone::Map::Coordinates(2, 2, 2))->getId() == Redstone::Component::ID::REDSTONE_DUST);
+	outputTest("mapB.get({3, 3, 3})", (Redstone::Component *)nullptr, mapB.get(Redstone::Map::Coordinates(3, 3, 3)));
+
+	mapA = mapB;
+	outputTest("mapA.get({0, 0, 0})->getId() == ID::SOLID_BLOCK after mapA = mapB", (1 == 1),
+		mapA.get(Redstone::Map::Coordinates(0, 0, 0))->getId() == Redstone::Component::ID::SOLID_BLOCK);
+}
+
+
+/**
+ * @brief Test copies of a map sharing chunks until one changes
+ */
+void testSharedChunks()
+{
+	Redstone::Map mapA(20, 20, 20);
+	Redstone::Map::Coordinates near(1, 1, 1), far(19, 19, 19);
+	mapA.set(near, mapA.make<Redstone::RedstoneDust>());
+	mapA.set(far, mapA.make<Redstone::RedstoneDust>());
+
+	const Redstone::Map mapB(mapA);
+	outputTest("mapB.get(near) == mapA.get(near) before writing", (1 == 1),
+		mapB.get(near) == static_cast<const Redstone::Map &>(mapA).get(near));
+
+	Redstone::Map mapC(mapB);
+	mapC.set(near, new Redstone::SolidBlock());
+	outputTest("mapB.get(near)->getId() == ID::REDSTONE_DUST after mapC.set", (1 == 1),
+		mapB.get(near)->getId() == Redstone::Component::ID::REDSTONE_DUST);
+	outputTest("mapC.get(near)->getId() == ID::SOLID_BLOCK", (1 == 1),
+		mapC.get(near)->getId() == Redstone::Component::ID::SOLID_BLOCK);
+	outputTest("mapC.get(far) == mapB.get(far) in a chunk not written", (1 == 1),
+		static_cast<const Redstone::Map &>(mapC).get(far) == mapB.get(far));
+
+	outputTest("mapA.get(far) != mapB.get(far) once it could be changed", (1 == 1),
+		mapA.get(far) != mapB.get(far));
+	outputTest("*mapA.get(far) == *mapB.get(far)", (1 == 1),
+		*mapA.get(far) == *mapB.get(far));
+}
+
+
+/**
+ * @brief Test moving maps instead of copying them
+ */
+void testMovingMaps()
+{
+	Redstone::Map mapA(4, 4, 4);
+	Redstone::Map::Coordinates coords(1, 2, 3);
+	Redstone::Component * dust = mapA.make<Redstone::RedstoneDust>();
+	mapA.set(coords, dust);
+
+	Redstone::Map mapB(std::move(mapA));
+	outputTest("mapB.get(coords) == dust after moving", (1 == 1), mapB.get(coords) == dust);
+	outputTest("mapA.volume() after moving", (size_t)0, mapA.volume());
+	outputTest("mapA.get(coords) after moving", (Redstone::Component *)nullptr, mapA.get(coords));
+
+	mapA = Redstone::Map(2, 2, 2);
+	outputTest("mapA.volume() after assigning a new map", (size_t)8, mapA.volume());
+
+	mapA = std::move(mapB);
+	outputTest("mapA.get(coords) == dust after moving back", (1 == 1), mapA.get(coords) == dust);
+	outputTest("mapB.volume() after moving back", (size_t)0, mapB.volume());
+}
+
+
+/**
+ * @brief Test maps that grow to take in whatever is set in them
+ */
+void testGrowingMaps()
+{
+	Redstone::Map mapA;
+	Redstone::Map::Coordinates a(-5, 3, 100), b(20, -40, 0);
+	mapA.set(a, new Redstone::RedstoneDust());
+	outputTest("mapA.volume() after setting one", (size_t)1, mapA.volume());
+	outputTest("mapA.origin().z", 100, mapA.origin().z);
+
+	mapA.set(b, new Redstone::SolidBlock());
+	outputTest("mapA.size().x", (size_t)26, mapA.size().x);
+	outputTest("mapA.size().y", (size_t)44, mapA.size().y);
+	outputTest("mapA.size().z", (size_t)101, mapA.size().z);
+	outputTest("mapA.get(a)->getId() == ID::REDSTONE_DUST", (1 == 1),
+		mapA.get(a)->getId() == Redstone::Component::ID::REDSTONE_DUST);
+	outputTest("mapA.get(b)->getId() == ID::SOLID_BLOCK", (1 == 1),
+		mapA.get(b)->getId() == Redstone::Component::ID::SOLID_BLOCK);
+	outputTest("mapA.get({0, 0, 50})", (Redstone::Component *)nullptr,
+		mapA.get(Redstone::Map::Coordinates(0, 0, 50)));
+
+	Redstone::Map::Coordinates back = mapA.coordinates(mapA.index(b));
+	outputTest("coordinates(index(b)) == b", (1 == 1), back.x == b.x && back.y == b.y && back.z == b.z);
+
+	int count = 0;
+	mapA.forEach([&count](const Redstone::Map::Coordinates &, const Redstone::Component *) {
+		++count;
+	});
+	outputTest("components visited by forEach", 2, count);
+
+	Redstone::PackedMap packed(mapA);
+	Redstone::Map mapB = packed.toMap();
+	outputTest("packed.toMap().get(a)->getId() == ID::REDSTONE_DUST", (1 == 1),
+		mapB.get(a) && mapB.get(a)->getId() == Redstone::Component::ID::REDSTONE_DUST);
+}
+
+
+/**
+ * @brief Test that each layout puts every component back where it was set
+ */
+void testLayouts()
+{
+	for (auto layout : { Redstone::Map::Layout::LINEAR, Redstone::Map::Layout::MORTON }) {
+		Redstone::Map map(Redstone::Map::Coordinates(-3, -3, -3), Redstone::Map::Size(20, 20, 20), layout);
+		std::vector<Redstone::Component *> made(map.volume());
+		for (size_t i = 0; i != made.size(); ++i) {
+			made[i] = map.make<Redstone::SolidBlock>();
+			map.set(map.coordinates(i), made[i]);
+		}
+
+		bool same = true;
+		for (size_t i = 0; i != made.size(); ++i) {
+			if (map.get(map.coordinates(i)) != made[i])
+				same = false;
+		}
+		map.forEach([&](const Redstone::Map::Coordinates & coords, const Redstone::Component * comp) {
+			if (made[map.index(coords)] != comp)
+				same = false;
+		});
+
+		outputTest(layout == Redstone::Map::Layout::MORTON ?
+			"MORTON get and forEach match set" : "LINEAR get and forEach match set",
+			(1 == 1), same);
+	}
+}
+
+
+/**
+ * @brief Test that cursors find the same neighbours as Map::get
+ *
+ * The centers are picked to sit on chunk edges and the map's edges.
+ */
+void testCursors()
+{
+	Redstone::Map map(Redstone::Map::Coordinates(-10, -10, -10), Redstone::Map::Size(40, 40, 40));
+	for (size_t i = 0; i < map.volume(); i += 3)
+		map.set(map.coordinates(i), map.make<Redstone::SolidBlock>());
+
+	int points[] = { -11, -10, -1, 0, 15, 16, 29, 30 };
+	bool same = true;
+	for (int x : points) {
+		for (int y : points) {
+			for (int z : points) {
+				Redstone::Map::Cursor cursor(map, Redstone::Map::Coordinates(x, y, z));
+				for (int d = 0; d != 27; ++d) {
+					int dx = d % 3 - 1, dy = d / 3 % 3 - 1, dz = d / 9 - 1;
+					if (cursor.at(dx, dy, dz) != map.get(Redstone::Map::Coordinates(x + dx, y + dy, z + dz)))
+						same = false;
+				}
+			}
+		}
+	}
+	outputTest("cursor.at() matches map.get()", (1 == 1), same);
+}
+
+
+/**
+ * @brief Count the components in a map
+ * @param map	The map to count in
+ * @returns The number of components
+ */
+int countComponents(const Redstone::Map & map)
+{
+	int count = 0;
+	map.forEach([&count](const Redstone::Map::Coordinates &, const Redstone::Component *) {
+		++count;
+	});
+	return count;
+}
+
+
+/**
+ * @brief Test filling, clearing and copying boxes
+ */
+void testRegions()
+{
+	typedef Redstone::Map::Box Box;
+	typedef Redstone::Map::Coordinates Coords;
+	typedef Redstone::Map::Size Size;
+
+	Redstone::Map mapA;
+	Redstone::SolidBlock solid;
+	mapA.fill(Box(Coords(0, 0, 0), Size(64, 1, 64)), &solid);
+	outputTest("components after fill", 64 * 64, countComponents(mapA));
+	outputTest("mapA.size().z after fill", (size_t)64, mapA.size().z);
+
+	mapA.fill(Box(Coords(0, 1, 0), Size(64, 1, 64)), Redstone::GlassBlock::shared());
+	outputTest("mapA.get({5, 1, 5}) == GlassBlock::shared()", (1 == 1),
+		mapA.get(Coords(5, 1, 5)) == Redstone::GlassBlock::shared());
+
+	mapA.clear(Box(Coords(-8, 0, 0), Size(40, 2, 32)));
+	outputTest("components after clear", 2 * 64 * 64 - 2 * 32 * 32, countComponents(mapA));
+	outputTest("mapA.get({31, 0, 31})", (Redstone::Component *)nullptr, mapA.get(Coords(31, 0, 31)));
+	outputTest("mapA.get({32, 0, 31}) != nullptr", (1 == 1), mapA.get(Coords(32, 0, 31)) != nullptr);
+
+	// Lined up on chunks, so they are shared
+	Redstone::Map mapB;
+	mapA.copyRegion(Box(Coords(32, 0, 0), Size(32, 2, 64)), mapB, Coords(-64, 16, 0));
+	outputTest("components after copyRegion", 2 * 32 * 64, countComponents(mapB));
+	const Redstone::Map & constA = mapA;
+	const Redstone::Map & constB = mapB;
+	outputTest("chunk shared after lined up copyRegion", (1 == 1),
+		constB.get(Coords(-64, 16, 0)) == constA.get(Coords(32, 0, 0)));
+
+	// Not lined up, and overlapping itself
+	mapA.copyRegion(Box(Coords(32, 0, 32), Size(32, 2, 32)), mapA, Coords(33, 0, 33));
+	outputTest("mapA.get({33, 0, 33})->getId() == ID::SOLID_BLOCK", (1 == 1),
+		mapA.get(Coords(33, 0, 33))->getId() == Redstone::Component::ID::SOLID_BLOCK);
+	outputTest("mapA.get({64, 1, 64}) == GlassBlock::shared()", (1 == 1),
+		mapA.get(Coords(64, 1, 64)) == Redstone::GlassBlock::shared());
+	outputTest("components after copying onto itself", 2 * 64 * 64 - 2 * 32 * 32 + 2 * (32 + 31),
+		countComponents(mapA));
+}
+
+
+/**
+ * @brief Test measuring the memory a map holds
+ *
+ * Components should be counted by ID, and shared ones should take no
+ * bytes.  A copy of a map shares its chunks until it changes them.
+ */
+void testMemoryUsage()
+{
+	typedef Redstone::Map::Coordinates Coords;
+	const int SOLID = static_cast<int>(Redstone::Component::ID::SOLID_BLOCK);
+	const int GLASS = static_cast<int>(Redstone::Component::ID::GLASS_BLOCK);
+	const int TORCH = static_cast<int>(Redstone::Component::ID::REDSTONE_TORCH);
+
+	Redstone::Map map;
+	map.set(Coords(0, 0, 0), map.make<Redstone::SolidBlock>());
+	map.set(Coords(1, 0, 0), Redstone::GlassBlock::shared());
+	map.set(Coords(2, 0, 0), new Redstone::RedstoneTorch());
+
+	Redstone::Map::MemoryUsage usage = map.memoryUsage();
+	outputTest("usage.counts[SOLID]", (size_t)1, usage.counts[SOLID]);
+	outputTest("usage.components[SOLID]", Redstone::Arena::roundUp(sizeof(Redstone::SolidBlock)),
+		usage.components[SOLID]);
+	outputTest("usage.counts[GLASS]", (size_t)1, usage.counts[GLASS]);
+	outputTest("usage.components[GLASS]", (size_t)0, usage.components[GLASS]);
+	outputTest("usage.components[TORCH]", sizeof(Redstone::RedstoneTorch), usage.components[TORCH]);
+	outputTest("usage.chunks >= one table of pointers", (1 == 1),
+		usage.chunks >= 4096 * sizeof(Redstone::Component *));
+	outputTest("usage.chunkTable > 0", (1 == 1), usage.chunkTable > 0);
+	outputTest("usage.arenaUnused", 4096 - Redstone::Arena::roundUp(sizeof(Redstone::SolidBlock)),
+		usage.arenaUnused);
+	outputTest("usage.sharedChunks", (size_t)0, usage.sharedChunks);
+
+	// A copy shares the chunk until it changes it
+	Redstone::Map copy(map);
+	outputTest("usage.sharedChunks of a copy", usage.chunks, copy.memoryUsage().sharedChunks);
+	copy.set(Coords(3, 0, 0), copy.make<Redstone::SolidBlock>());
+	outputTest("usage.sharedChunks after a change", (size_t)0, copy.memoryUsage().sharedChunks);
+	outputTest("copy.memoryUsage().counts[SOLID]", (size_t)2, copy.memoryUsage().counts[SOLID]);
+}
+
+
+/**
+ * @brief Test the tables of how to make, save, and load components
+ *
+ * Every schematic block that loads as something should save as a block
+ * that loads as the same thing.  Blocks and IDs that aren't supported
+ * should make nothing.
+ */
+void testRegistry()
+{
+	typedef Redstone::ComponentRegistry Registry;
+	Redstone::Map map;
+
+	outputTest("fromBlock(1).id == ID::SOLID_BLOCK", (1 == 1),
+		Registry::fromBlock(1).id == Redstone::Component::ID::SOLID_BLOCK);
+	outputTest("fromBlock(0).make(map)", static_cast<Redstone::Component*>(nullptr),
+		Registry::fromBlock(0).make(map));
+	outputTest("fromBlock(7).make(map)", static_cast<Redstone::Component*>(nullptr),
+		Registry::fromBlock(7).make(map));
+	outputTest("fromId(ID::HOPPER).make(map)", static_cast<Redstone::Component*>(nullptr),
+		Registry::fromId(Redstone::Component::ID::HOPPER).make(map));
+
+	// Load and save every block
+	int made = 0, mismatched = 0;
+	for (int block = 0; block != 256; ++block) {
+		Redstone::Component * comp = Registry::fromBlock(block).make(map);
+		if (comp == nullptr)
+			continue;
+
+		++made;
+		uint8_t saved = Registry::fromId(comp->getId()).block(*comp);
+		if (comp->getId() != Registry::fromBlock(block).id
+				|| Registry::fromBlock(saved).id != comp->getId())
+			++mismatched;
+		map.set(Redstone::Map::Coordinates(block, 0, 0), comp);
+	}
+	outputTest("blocks supported", 58, made);
+	outputTest("blocks that don't load back the same", 0, mismatched);
+
+	// State that lives in the block ID and the data
+	const Redstone::Component * torch = map.get(Redstone::Map::Coordinates(75, 0, 0));
+	outputTest("torch from block 75 is on", (1 == 0),
+		Redstone::componentCast<Redstone::RedstoneTorch>(*torch).isOn());
+	outputTest("torch from block 75 saves as", 75,
+		static_cast<int>(Registry::fromId(torch->getId()).block(*torch)));
+
+	Redstone::Component * lever = map.get(Redstone::Map::Coordinates(69, 0, 0));
+	Registry::fromId(lever->getId()).read(*lever, 8 | 3);
+	outputTest("lever from data 11 is on", (1 == 1),
+		Redstone::componentCast<Redstone::Switch>(lever)->isOn());
+	outputTest("lever from data 11 saves as", 11,
+		static_cast<int>(Registry::fromId(lever->getId()).data(*lever)));
+}
+
+
 /**
  * @brief Main function
  */
@@ -186,6 +621,39 @@ int main()
 	std::cout << "--Testing full maps..." << std::endl << std::endl;
 	testFullMaps();
 
+	std::cout << "--Testing packed maps..." << std::endl << std::endl;
+	testPackedMaps();
+
+	std::cout << "--Testing shared components..." << std::endl << std::endl;
+	testSharedComponents();
+
+	std::cout << "--Testing components made in a map..." << std::endl << std::endl;
+	testMadeComponents();
+
+	std::cout << "--Testing copies sharing chunks..." << std::endl << std::endl;
+	testSharedChunks();
+
+	std::cout << "--Testing moving maps..." << std::endl << std::endl;
+	testMovingMaps();
+
+	std::cout << "--Testing growing maps..." << std::endl << std::endl;
+	testGrowingMaps();
+
+	std::cout << "--Testing layouts..." << std::endl << std::endl;
+	testLayouts();
+
+	std::cout << "--Testing cursors..." << std::endl << std::endl;
+	testCursors();
+
+	std::cout << "--Testing regions..." << std::endl << std::endl;
+	testRegions();
+
+	std::cout << "--Testing memory usage..." << std::endl << std::endl;
+	testMemoryUsage();
+
+	std::cout << "--Testing the component registry..." << std::endl << std::endl;
+	testRegistry();
+
 	// Done
 	std::cout << "== done ==" << std::endl << std::endl;
 }